@@ -0,0 +1,521 @@
+#include "pywrap/Pywrap.h"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+
+#include <llvm/Support/Format.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+
+#include "pywrap/Ir.h"
+#include "pywrap/Profile.h"
+
+
+/// Generates synthetic annotated headers and runs the whole pipeline over them,
+/// reporting the throughput of extraction and code generation
+
+static llvm::cl::OptionCategory bench_category{ "Benchmark options" };
+
+static llvm::cl::opt<std::string> output{ "o", llvm::cl::desc( "Directory of the headers, sources and outputs" ),
+	                                      llvm::cl::value_desc( "dir" ), llvm::cl::init( "pywrap-bench" ),
+	                                      llvm::cl::cat( bench_category ) };
+
+static llvm::cl::opt<unsigned> units{ "units", llvm::cl::desc( "Number of translation units" ), llvm::cl::init( 4 ),
+	                                  llvm::cl::cat( bench_category ) };
+
+static llvm::cl::opt<unsigned> namespaces{ "namespaces", llvm::cl::desc( "Number of namespaces, one header each" ),
+	                                       llvm::cl::init( 8 ), llvm::cl::cat( bench_category ) };
+
+static llvm::cl::opt<unsigned> records{ "records", llvm::cl::desc( "Number of records per namespace" ),
+	                                    llvm::cl::init( 32 ), llvm::cl::cat( bench_category ) };
+
+static llvm::cl::opt<unsigned> fields{ "fields", llvm::cl::desc( "Number of fields per record" ), llvm::cl::init( 8 ),
+	                                   llvm::cl::cat( bench_category ) };
+
+static llvm::cl::opt<unsigned> enums{ "enums", llvm::cl::desc( "Number of enums per namespace" ), llvm::cl::init( 8 ),
+	                                  llvm::cl::cat( bench_category ) };
+
+static llvm::cl::opt<unsigned> functions{ "functions", llvm::cl::desc( "Number of functions per namespace" ),
+	                                      llvm::cl::init( 32 ), llvm::cl::cat( bench_category ) };
+
+static llvm::cl::opt<unsigned> specializations{ "specializations",
+	                                            llvm::cl::desc( "Number of template specializations per namespace" ),
+	                                            llvm::cl::init( 8 ), llvm::cl::cat( bench_category ) };
+
+static llvm::cl::opt<unsigned> jobs{ "j", llvm::cl::desc( "Number of translation units to process in parallel" ),
+	                                 llvm::cl::value_desc( "N" ), llvm::cl::init( 1 ),
+	                                 llvm::cl::cat( bench_category ) };
+
+static llvm::cl::opt<unsigned> bindings_shards{ "bindings-shards",
+	                                            llvm::cl::desc( "Split the bindings source into N shards" ),
+	                                            llvm::cl::value_desc( "N" ), llvm::cl::init( 1 ),
+	                                            llvm::cl::cat( bench_category ) };
+
+static llvm::cl::opt<bool> check_order{
+	"check-order",
+	llvm::cl::desc( "Generate the outputs again from permuted sources, with one job and with -j jobs, "
+	                "and check that they are byte-identical" ),
+	llvm::cl::cat( bench_category )
+};
+
+static llvm::cl::opt<unsigned> check_scaling{
+	"check-scaling",
+	llvm::cl::desc( "Merge the IR of N and of 4N synthetic declarations, without parsing them, "
+	                "and check that the merge and index times grow linearly" ),
+	llvm::cl::value_desc( "N" ), llvm::cl::init( 0 ), llvm::cl::cat( bench_category )
+};
+
+
+/// Times more declarations merged by the second run of the scaling check
+static const unsigned scaling_factor = 4;
+
+/// Growth of the time, over the growth of the declarations, above which the scaling check fails
+static const double scaling_tolerance = 2.0;
+
+/// Translation units of the scaling check, every declaration is extracted by two of them
+static const size_t scaling_units = 8;
+
+/// Declarations within a module of the scaling check
+static const size_t scaling_module_decls = 256;
+
+
+/// Types used as template arguments, a template is generated for every group of them
+static const char* arg_types[] = { "int", "float", "double", "long", "short", "unsigned", "char", "bool" };
+
+static const char* field_types[] = { "int", "float", "double", "bool" };
+
+
+/// @return The number of annotated declarations within a header
+static size_t count_decls()
+{
+	return records + enums + functions + specializations;
+}
+
+
+/// Writes the header of a namespace
+/// @param[in] os Output stream
+/// @param[in] n Index of the namespace
+static void generate_header( llvm::raw_ostream& os, const unsigned n )
+{
+	os << "#pragma once\n\n"
+	   << "#define PYSPOT_EXPORT __attribute__( ( annotate( \"pyspot\" ) ) )\n\n"
+	   << "namespace bench\n{\nnamespace ns" << n << "\n{\n";
+
+	for ( unsigned e = 0; e < enums; ++e )
+	{
+		os << "enum class PYSPOT_EXPORT Enum" << e << " { A, B, C, D };\n\n";
+	}
+
+	for ( unsigned r = 0; r < records; ++r )
+	{
+		os << "struct PYSPOT_EXPORT Record" << r << "\n{\n";
+		for ( unsigned f = 0; f < fields; ++f )
+		{
+			os << "\t" << field_types[f % llvm::array_lengthof( field_types )] << " field" << f << ";\n";
+		}
+		os << "};\n\n";
+	}
+
+	for ( unsigned f = 0; f < functions; ++f )
+	{
+		os << "PYSPOT_EXPORT int function" << f << "( int a, float b );\n\n";
+	}
+
+	// Every template is explicitly instantiated for a group of argument types
+	auto types = llvm::array_lengthof( arg_types );
+	for ( unsigned s = 0, t = 0; s < specializations; ++t )
+	{
+		os << "template <typename T>\nstruct PYSPOT_EXPORT Box" << t << "\n{\n\tT value;\n};\n\n";
+		for ( size_t a = 0; a < types && s < specializations; ++a, ++s )
+		{
+			os << "template struct Box" << t << "<" << arg_types[a] << ">;\n";
+		}
+		os << "\n";
+	}
+
+	os << "}  // namespace ns" << n << "\n}  // namespace bench\n";
+}
+
+
+/// Writes headers and sources into the output directory
+/// @return The absolute paths of the sources, empty on failure
+static std::vector<std::string> generate()
+{
+	llvm::SmallString<256> include{ output };
+	llvm::sys::path::append( include, "include", "bench" );
+	if ( auto error = llvm::sys::fs::create_directories( include ) )
+	{
+		llvm::errs() << " while creating '" << include << "': " << error.message() << '\n';
+		return {};
+	}
+
+	for ( unsigned n = 0; n < namespaces; ++n )
+	{
+		llvm::SmallString<256> path{ include };
+		llvm::sys::path::append( path, "Namespace" + std::to_string( n ) + ".h" );
+
+		std::error_code      error;
+		llvm::raw_fd_ostream file{ path, error, llvm::sys::fs::F_Text };
+		if ( error )
+		{
+			llvm::errs() << " while opening '" << path << "': " << error.message() << '\n';
+			return {};
+		}
+		generate_header( file, n );
+	}
+
+	// Every translation unit includes every header, starting from a different one, and adds a specialization of its own
+	std::vector<std::string> sources;
+	for ( unsigned u = 0; u < units; ++u )
+	{
+		llvm::SmallString<256> path{ output };
+		llvm::sys::path::append( path, "Unit" + std::to_string( u ) + ".cpp" );
+
+		std::error_code      error;
+		llvm::raw_fd_ostream file{ path, error, llvm::sys::fs::F_Text };
+		if ( error )
+		{
+			llvm::errs() << " while opening '" << path << "': " << error.message() << '\n';
+			return {};
+		}
+		for ( unsigned n = 0; n < namespaces; ++n )
+		{
+			file << "#include \"bench/Namespace" << ( u + n ) % namespaces << ".h\"\n";
+		}
+		if ( namespaces > 0 && specializations > 0 )
+		{
+			file << "\nnamespace bench\n{\nstruct PYSPOT_EXPORT Unit" << u << "\n{\n\tint value;\n};\n"
+			     << "}  // namespace bench\n\n"
+			     << "template struct bench::ns0::Box0<bench::Unit" << u << ">;\n";
+		}
+		sources.emplace_back( path.str() );
+	}
+
+	return sources;
+}
+
+
+/// @return The total size of the generated outputs in bytes
+static uint64_t get_output_size()
+{
+	uint64_t size = 0;
+	for ( auto dir : { "include/pyspot", "src/pyspot" } )
+	{
+		std::error_code error;
+		for ( llvm::sys::fs::directory_iterator it{ dir, error }, end; it != end && !error; it.increment( error ) )
+		{
+			uint64_t file_size = 0;
+			if ( !llvm::sys::fs::file_size( it->path(), file_size ) )
+			{
+				size += file_size;
+			}
+		}
+	}
+	return size;
+}
+
+
+/// Extracts the bindings of the sources and generates the outputs within a directory
+/// @param[in] db Compilation database of the sources
+/// @param[in] sources Sources to extract
+/// @param[in] job_count Number of translation units to process in parallel
+/// @param[in] dir Directory of the outputs
+/// @return The paths of the outputs relative to the directory, empty on failure
+static std::vector<std::string> generate_outputs( const clang::tooling::CompilationDatabase& db,
+                                                  const std::vector<std::string>& sources, const unsigned job_count,
+                                                  const std::string& dir )
+{
+	pywrap::Driver driver{ db, job_count };
+	if ( driver.run( sources ) != EXIT_SUCCESS )
+	{
+		return {};
+	}
+
+	llvm::sys::fs::create_directories( dir );
+	llvm::sys::fs::set_current_path( dir );
+	pywrap::Printer printer{};
+	printer.set_shards( bindings_shards );
+	printer.print_out( driver.get_modules() );
+	return printer.get_outputs();
+}
+
+
+/// @return Whether two files exist and have the same contents
+static bool equal_files( const std::string& a, const std::string& b )
+{
+	auto a_buffer = llvm::MemoryBuffer::getFile( a );
+	auto b_buffer = llvm::MemoryBuffer::getFile( b );
+	return a_buffer && b_buffer && ( *a_buffer )->getBuffer() == ( *b_buffer )->getBuffer();
+}
+
+
+/// Generates the outputs again from permutations of the sources, one job at a time and in parallel
+/// @param[in] db Compilation database of the sources
+/// @param[in] sources Sources in the order of the first run
+/// @param[in] outputs Paths of the outputs of the first run, relative to the output directory
+/// @return Whether every run generated the same outputs of the first one, byte for byte
+static bool check_outputs( const clang::tooling::CompilationDatabase& db, const std::vector<std::string>& sources,
+                           const std::vector<std::string>& outputs )
+{
+	auto reversed = sources;
+	std::reverse( reversed.begin(), reversed.end() );
+
+	// A fixed seed, so a failure can be reproduced
+	auto shuffled = sources;
+	std::shuffle( shuffled.begin(), shuffled.end(), std::mt19937{ 42 } );
+
+	auto parallel = jobs > 1 ? jobs.getValue() : 0u;
+
+	struct Permutation
+	{
+		const char*                     name;
+		const std::vector<std::string>& sources;
+	};
+
+	bool ret = true;
+	for ( auto& permutation : { Permutation{ "reversed", reversed }, Permutation{ "shuffled", shuffled } } )
+	{
+		for ( auto job_count : { 1u, parallel } )
+		{
+			auto run = std::string{ permutation.name } + "-j" + std::to_string( job_count );
+
+			llvm::SmallString<256> dir{ output };
+			llvm::sys::path::append( dir, "check", run );
+
+			auto check = generate_outputs( db, permutation.sources, job_count, dir.str() );
+			if ( check != outputs )
+			{
+				llvm::errs() << "Outputs differ with " << run << ": a different set of files was generated\n";
+				ret = false;
+				continue;
+			}
+
+			for ( auto& path : outputs )
+			{
+				llvm::SmallString<256> expected{ output };
+				llvm::sys::path::append( expected, path );
+				llvm::SmallString<256> actual{ dir };
+				llvm::sys::path::append( actual, path );
+				if ( !equal_files( expected.str(), actual.str() ) )
+				{
+					llvm::errs() << "Outputs differ with " << run << ": " << path << '\n';
+					ret = false;
+				}
+			}
+		}
+	}
+
+	return ret;
+}
+
+
+/// Builds the IR of translation units sharing headers, without parsing anything
+/// @param[in] decls Number of unique declarations, split into modules
+/// @return The IR of every translation unit, each declaration appearing in two consecutive ones
+static std::vector<pywrap::ir::Modules> generate_ir( const size_t decls )
+{
+	std::vector<pywrap::ir::Modules> ret( scaling_units );
+
+	auto share = ( decls + scaling_units - 1 ) / scaling_units;
+	for ( size_t u = 0; u < scaling_units; ++u )
+	{
+		for ( auto i = u * share; i < ( u + 2 ) * share; ++i )
+		{
+			auto d  = i % decls;
+			auto ns = "bench::ns" + std::to_string( d / scaling_module_decls );
+
+			auto& module = ret[u][ns];
+			module.id    = ns;
+			module.name  = ns;
+
+			pywrap::ir::Binding binding;
+			binding.id   = ns + "::Decl" + std::to_string( d );
+			binding.name = "Decl" + std::to_string( d );
+			binding.decl = "// " + binding.id + "\n";
+			binding.def  = binding.decl;
+
+			// Records, functions and templates, which gain a specialization from every translation unit
+			switch ( d % 3 )
+			{
+				case 0:
+				{
+					auto field   = binding;
+					field.kind   = pywrap::ir::Kind::Field;
+					binding.kind = pywrap::ir::Kind::Record;
+					binding.fields.emplace_back( std::move( field ) );
+					module.records.emplace_back( std::move( binding ) );
+					break;
+				}
+				case 1:
+				{
+					module.functions.emplace_back( std::move( binding ) );
+					break;
+				}
+				default:
+				{
+					auto item = binding;
+					item.id += "<Unit" + std::to_string( u ) + ">";
+
+					binding.kind = pywrap::ir::Kind::Template;
+					binding.items.emplace_back( std::move( item ) );
+					module.templates.emplace_back( std::move( binding ) );
+					break;
+				}
+			}
+		}
+	}
+
+	return ret;
+}
+
+
+/// Wall times of the scaling check, the lowest of a few runs
+struct ScalingTimes
+{
+	/// Merge of every translation unit, then sort
+	double merge = std::numeric_limits<double>::max();
+
+	/// Merge of one more translation unit, which rebuilds the indexes reset by the sort
+	double index = std::numeric_limits<double>::max();
+};
+
+
+/// @param[in] decls Number of unique declarations
+/// @return The times to merge the IR of the declarations
+static ScalingTimes time_merge( const size_t decls )
+{
+	ScalingTimes ret;
+	for ( unsigned run = 0; run < 3; ++run )
+	{
+		auto units = generate_ir( decls );
+		auto extra = generate_ir( decls ).front();
+
+		pywrap::ir::Modules modules;
+
+		auto start = pywrap::Time::now();
+		for ( auto& unit : units )
+		{
+			pywrap::ir::merge( modules, std::move( unit ) );
+		}
+		pywrap::ir::sort( modules );
+		auto merged = pywrap::Time::now();
+		pywrap::ir::merge( modules, std::move( extra ) );
+		auto indexed = pywrap::Time::now();
+
+		ret.merge = std::min( ret.merge, ( merged - start ).wall );
+		ret.index = std::min( ret.index, ( indexed - merged ).wall );
+	}
+	return ret;
+}
+
+
+/// Merges the IR of N and of a multiple of N declarations
+/// @param[in] decls Number N of unique declarations of the first run
+/// @return Whether the times grew at most linearly, within the tolerance
+static bool check_merge_scaling( const size_t decls )
+{
+	auto small = time_merge( decls );
+	auto large = time_merge( decls * scaling_factor );
+
+	struct Phase
+	{
+		const char* name;
+		double      small;
+		double      large;
+	};
+
+	bool ret = true;
+	for ( auto& phase : { Phase{ "Merge", small.merge, large.merge }, Phase{ "Index", small.index, large.index } } )
+	{
+		auto growth = phase.small > 0 ? phase.large / phase.small : 0.0;
+		llvm::outs() << llvm::format( "%s: %.4f s for %zu decls, %.4f s for %zu decls, %.1fx\n", phase.name,
+		                              phase.small, decls, phase.large, decls * scaling_factor, growth );
+		if ( growth > scaling_factor * scaling_tolerance )
+		{
+			llvm::errs() << phase.name << " time grows superlinearly: " << llvm::format( "%.1f", growth )
+			             << " times for " << scaling_factor << " times the declarations\n";
+			ret = false;
+		}
+	}
+	return ret;
+}
+
+
+int main( int argc, const char** argv )
+{
+	llvm::cl::HideUnrelatedOptions( bench_category );
+	llvm::cl::ParseCommandLineOptions( argc, argv, "Pywrap benchmark\n" );
+
+	// Paths are absolute, as outputs are printed relative to the working directory
+	llvm::SmallString<256> dir{ output };
+	llvm::sys::fs::make_absolute( dir );
+	output = dir.str();
+
+	auto sources = generate();
+	if ( sources.empty() )
+	{
+		return EXIT_FAILURE;
+	}
+
+	std::vector<std::string>                 args{ "-xc++", "-std=c++14", "-I" + output + "/include" };
+	clang::tooling::FixedCompilationDatabase db{ output, args };
+
+	pywrap::TimeReport report;
+	pywrap::Driver     driver{ db, jobs };
+	driver.set_time_report( &report );
+
+	auto start = pywrap::Time::now();
+	if ( auto code = driver.run( sources ) )
+	{
+		return code;
+	}
+	auto extracted = pywrap::Time::now();
+
+	llvm::sys::fs::set_current_path( output );
+	pywrap::Printer printer{};
+	printer.set_shards( bindings_shards );
+	printer.print_out( driver.get_modules() );
+	auto printed = pywrap::Time::now();
+
+	size_t decls = 0;
+	for ( auto& unit : report.get_units() )
+	{
+		decls += unit.matched_decls;
+	}
+	auto extract_time = ( extracted - start ).wall;
+	auto merge_time   = report.get_phase( "merge" ).wall;
+	auto print_time   = ( printed - extracted ).wall;
+	auto bytes        = get_output_size();
+
+	llvm::outs() << "Translation units:   " << sources.size() << " (" << count_decls() * namespaces
+	             << " annotated declarations each)\n"
+	             << "Matched declarations: " << decls << '\n'
+	             << llvm::format( "Extraction:          %.3f s, %.0f decls/s\n", extract_time,
+	                              extract_time > 0 ? decls / extract_time : 0.0 )
+	             << llvm::format( "Merge:               %.3f s, %.0f decls/s\n", merge_time,
+	                              merge_time > 0 ? decls / merge_time : 0.0 )
+	             << llvm::format( "Code generation:     %.3f s, %.0f bytes/s (%llu bytes)\n", print_time,
+	                              print_time > 0 ? bytes / print_time : 0.0, static_cast<unsigned long long>( bytes ) )
+	             << llvm::format( "Peak memory:         %.1f MiB\n", pywrap::get_peak_memory() / ( 1024.0 * 1024.0 ) );
+
+	if ( check_order )
+	{
+		if ( !check_outputs( db, sources, printer.get_outputs() ) )
+		{
+			return EXIT_FAILURE;
+		}
+		llvm::outs() << "Outputs are byte-identical with permuted sources and any number of jobs\n";
+	}
+
+	if ( check_scaling )
+	{
+		if ( !check_merge_scaling( check_scaling ) )
+		{
+			return EXIT_FAILURE;
+		}
+		llvm::outs() << "Merge and index times grow linearly with the declarations\n";
+	}
+
+	return EXIT_SUCCESS;
+}
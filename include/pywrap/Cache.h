@@ -0,0 +1,58 @@
+#ifndef PYWRAP_CACHE_H_
+#define PYWRAP_CACHE_H_
+
+#include <string>
+#include <vector>
+
+#include <clang/Tooling/CompilationDatabase.h>
+#include <llvm/Support/Chrono.h>
+
+#include "pywrap/Ir.h"
+
+namespace pywrap
+{
+/// @param[in] path Path of a file
+/// @return The hex MD5 of the contents of the file, or an empty string if it can not be read
+std::string hash_file( const std::string& path );
+
+
+/// On-disk cache of the bindings extracted from translation units.
+/// An entry is keyed by the compile commands of a translation unit, and it is
+/// valid as long as the contents of every file read by the frontend did not change
+class Cache
+{
+  public:
+	/// @param[in] dir Directory where entries are stored
+	/// @param[in] options Options affecting the extracted bindings, part of the key of every entry
+	Cache( std::string dir, std::string options = "" );
+
+	/// Loads the bindings of a translation unit
+	/// @param[in] commands Compile commands of the translation unit
+	/// @param[out] modules Map to populate with the cached modules
+	/// @param[out] dependencies Files read by the translation unit
+	/// @return False if there is no entry or any of the files changed
+	bool load( const std::vector<clang::tooling::CompileCommand>& commands, ir::Modules& modules,
+	           std::vector<std::string>& dependencies ) const;
+
+	/// Stores the bindings of a translation unit, unless any of its files was modified after the parse started,
+	/// as the hash of the contents read now could differ from the contents the frontend read
+	/// @param[in] commands Compile commands of the translation unit
+	/// @param[in] modules Modules extracted from the translation unit
+	/// @param[in] dependencies Absolute paths of the files read by the translation unit
+	/// @param[in] parse_start Time before the translation unit was parsed
+	void store( const std::vector<clang::tooling::CompileCommand>& commands, const ir::Modules& modules,
+	            const std::vector<std::string>& dependencies, llvm::sys::TimePoint<> parse_start ) const;
+
+  private:
+	/// @return The path of the entry for these compile commands
+	std::string get_path( const std::vector<clang::tooling::CompileCommand>& commands ) const;
+
+	std::string dir;
+
+	std::string options;
+};
+
+
+}  // namespace pywrap
+
+#endif  // PYWRAP_CACHE_H_
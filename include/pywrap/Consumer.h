@@ -5,21 +5,40 @@
 
 #include "pywrap/FrontendAction.h"
 #include "pywrap/MatchHandler.h"
+#include "pywrap/PathFilter.h"
 
 namespace pywrap
 {
 /// Implementation of the ASTConsumer interface for reading an AST produced
-/// by the Clang parser. It registers a couple of matchers and runs them on the AST.
+/// by the Clang parser, or loaded from an AST file. It registers a couple of matchers and runs them on the AST.
 class Consumer : public clang::ASTConsumer
 {
   public:
-	Consumer( std::unordered_map<std::string, binding::Module>& m, FrontendAction& frontend );
-
+	/// @param[in] m Modules to populate with the bindings of the translation unit
+	/// @param[in] options Options of the extraction
+	/// @param[in] unit Translation unit within the run
+	/// @param[in] includes Include directories, which are removed from the paths of the headers
+	Consumer( ir::Modules& m, const FrontendOptions& options, const Unit& unit,
+	          const std::vector<std::string>& includes );
+
+	/// Matches the declarations, then converts their bindings to IR while the AST is still alive
 	void HandleTranslationUnit( clang::ASTContext& context ) override;
 
   private:
+	/// Modules to populate
+	ir::Modules& modules;
+
+	/// Bindings of the translation unit, which refer to its AST
+	std::unordered_map<std::string, binding::Module> bindings;
+
 	MatchHandler handler;
 
+	/// Files whose declarations are exported
+	PathFilter filter;
+
+	/// Profile of the translation unit, if the run is timed
+	UnitProfile* profile = nullptr;
+
 	clang::ast_matchers::MatchFinder matcher;
 };
 
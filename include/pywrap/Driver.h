@@ -0,0 +1,255 @@
+#ifndef PYWRAP_DRIVER_H_
+#define PYWRAP_DRIVER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <clang/Tooling/CompilationDatabase.h>
+
+#include "pywrap/Cache.h"
+#include "pywrap/Extracted.h"
+#include "pywrap/FrontendAction.h"
+#include "pywrap/Ir.h"
+#include "pywrap/Pch.h"
+
+namespace pywrap
+{
+/// Runs the frontend action over a list of sources, splitting
+/// them across a number of worker threads
+class Driver
+{
+  public:
+	/// Statistics of a run
+	struct Stats
+	{
+		/// Declarations skipped as already claimed by a preceding translation unit
+		size_t skipped_decls = 0;
+
+		/// Translation units extracted again, every one for a run and the affected ones for an update
+		size_t extracted_units = 0;
+	};
+
+	/// @param[in] db Compilation database providing the compile commands
+	/// @param[in] jobs Number of worker threads, 0 means one per core
+	Driver( const clang::tooling::CompilationDatabase& db, unsigned jobs = 1 );
+
+	/// Enables the on-disk cache of extracted bindings
+	/// @param[in] dir Directory of the cache
+	void set_cache( const std::string& dir )
+	{
+		cache_dir = dir;
+	}
+
+	/// Restricts the exported declarations to the files selected by regular expressions over their path
+	/// @param[in] include Only files matching it are selected, every file if empty
+	/// @param[in] exclude Files matching it are not selected, none if empty
+	void set_path_filter( const std::string& include, const std::string& exclude )
+	{
+		options.include_path_regex = include;
+		options.exclude_path_regex = exclude;
+	}
+
+	/// Writes an IR file for every translation unit
+	/// @param[in] dir Directory where IR files are written
+	/// @param[in] json Whether to write a JSON dump next to every IR file
+	void set_ir_output( const std::string& dir, bool json = false )
+	{
+		ir_dir  = dir;
+		ir_json = json;
+	}
+
+	/// Parses declarations only, skipping function bodies unless a translation unit fails without them
+	void set_skip_function_bodies( bool skip )
+	{
+		options.skip_function_bodies = skip;
+	}
+
+	/// Precompiles a header included first by every translation unit, which loads it instead of parsing it.
+	/// It is built with the compile command of the first source, and kept within the cache directory if any
+	/// @param[in] header Header to precompile, none if empty
+	void set_pch( const std::string& header )
+	{
+		pch_header = header;
+	}
+
+	/// Keeps the results and the dependencies of every translation unit, so an update extracts only the affected ones.
+	/// Declarations shared by translation units are then extracted by every one of them
+	void set_incremental( bool inc )
+	{
+		incremental = inc;
+	}
+
+	/// Records the files read by every translation unit, so the inputs of a run are known
+	void set_track_dependencies( bool track )
+	{
+		track_dependencies = track;
+	}
+
+	/// Records the time spent by the next runs into a report
+	/// @param[in] r Report to fill, nothing is recorded if null
+	void set_time_report( TimeReport* r )
+	{
+		report = r;
+	}
+
+	/// Records the peak memory of the next runs and the memory held by their bindings into a report
+	/// @param[in] r Report to fill, nothing is recorded if null
+	void set_memory_report( MemoryReport* r )
+	{
+		memory_report = r;
+	}
+
+	/// Parses and matches every source, or loads it if it is an AST file, then merges the modules of every translation unit
+	/// @param[in] sources Source files to process
+	/// @return The result of the tool, EXIT_SUCCESS on success
+	int run( const std::vector<std::string>& sources );
+
+	/// Extracts again the translation units of the last run reading any of the changed files, then merges every one again
+	/// @param[in] files Absolute paths of the changed files
+	/// @return The result of the tool over every translation unit, EXIT_SUCCESS on success
+	int update( const std::vector<std::string>& files );
+
+	/// @return The modules extracted by the last run
+	ir::Modules& get_modules()
+	{
+		return modules;
+	}
+
+	/// @return The statistics of the last run
+	const Stats& get_stats() const
+	{
+		return stats;
+	}
+
+	/// @return The sources of the last run
+	const std::vector<std::string>& get_sources() const
+	{
+		return sources;
+	}
+
+	/// @return Absolute paths of the files read by every translation unit of the last run, if cached, incremental or tracked
+	const std::vector<std::vector<std::string>>& get_dependencies() const
+	{
+		return dependencies;
+	}
+
+	/// @param[in] all_headers Whether to include every header, rather than only the ones with exported declarations
+	/// @return Absolute paths of the sources of the last run and of the headers they read, sorted and unique
+	std::vector<std::string> get_inputs( bool all_headers = false ) const;
+
+  private:
+	/// Extracts the bindings of a single translation unit and writes its IR file if requested
+	/// @param[in] source Source file to process
+	/// @param[in] unit Translation unit within the run
+	/// @param[out] result Modules extracted from the source
+	/// @param[out] files Absolute paths of the files read by the translation unit, when cached or incremental
+	/// @return The result of the tool, EXIT_SUCCESS on success
+	int process( const std::string& source, const Unit& unit, ir::Modules& result, std::vector<std::string>& files );
+
+	/// Runs the frontend action over a single translation unit
+	/// @param[in] source Source file to process
+	/// @param[in] unit Translation unit within the run
+	/// @param[in] opts Options of the frontend action
+	/// @param[in] use_pch Whether to load the precompiled header, if any
+	/// @param[out] result Modules extracted from the source
+	/// @param[out] dependencies Files read by the frontend, relative to the directory of the compile command
+	/// @return The result of the tool, EXIT_SUCCESS on success
+	int parse( const std::string& source, const Unit& unit, const FrontendOptions& opts, bool use_pch,
+	           ir::Modules& result, std::vector<std::string>& dependencies ) const;
+
+	/// Runs the matchers over the AST loaded from a file, instead of parsing a source
+	/// @param[in] path AST file to load
+	/// @param[in] unit Translation unit within the run
+	/// @param[out] result Modules extracted from the AST
+	/// @return EXIT_SUCCESS on success
+	int load( const std::string& path, const Unit& unit, ir::Modules& result ) const;
+
+	/// Builds the precompiled header with the compile command of a source, or disables it on failure
+	/// @param[in] source First source of the run
+	void build_pch( const std::string& source );
+
+	/// Extracts the bindings of a single translation unit, from the cache when possible
+	/// @param[in] source Source file to process
+	/// @param[in] unit Translation unit within the run
+	/// @param[out] result Modules extracted from the source
+	/// @param[out] dependencies Absolute paths of the files read by the translation unit, when cached or incremental
+	/// @return The result of the tool, EXIT_SUCCESS on success
+	int extract( const std::string& source, const Unit& unit, ir::Modules& result,
+	             std::vector<std::string>& dependencies );
+
+	/// Extracts some translation units of the run in parallel
+	/// @param[in] indices Indices of the sources to extract
+	void extract_units( const std::vector<size_t>& indices );
+
+	/// Merges the results of every translation unit, following the order of the sources
+	void merge_units();
+
+	/// @return The highest result of the translation units
+	int get_code() const;
+
+	/// Writes the IR file of a translation unit
+	/// @param[in] source Source file of the translation unit
+	/// @param[in] result Modules extracted from the source
+	/// @return False if the file could not be written
+	bool write_ir( const std::string& source, const ir::Modules& result ) const;
+
+	const clang::tooling::CompilationDatabase& compilations;
+
+	unsigned jobs = 1;
+
+	FrontendOptions options;
+
+	/// Directory of the cache, disabled if empty
+	std::string cache_dir;
+
+	std::unique_ptr<Cache> cache;
+
+	/// Header to precompile, none if empty
+	std::string pch_header;
+
+	/// Precompiled header shared by the translation units of a run
+	std::unique_ptr<Pch> pch;
+
+	/// Declarations claimed by the translation units of a run
+	std::unique_ptr<Extracted> extracted;
+
+	/// Time report to fill, if any
+	TimeReport* report = nullptr;
+
+	/// Memory report to fill, if any
+	MemoryReport* memory_report = nullptr;
+
+	/// Directory of the IR files, none are written if empty
+	std::string ir_dir;
+
+	bool ir_json = false;
+
+	/// Whether the results are kept for updates
+	bool incremental = false;
+
+	/// Whether the files read by the translation units are recorded
+	bool track_dependencies = false;
+
+	/// Sources of the last run
+	std::vector<std::string> sources;
+
+	/// Modules extracted from every source
+	std::vector<ir::Modules> results;
+
+	/// Files read by every source
+	std::vector<std::vector<std::string>> dependencies;
+
+	/// Result of the tool for every source
+	std::vector<int> codes;
+
+	/// Map of global id of the DeclContext and the associated Module
+	ir::Modules modules;
+
+	Stats stats;
+};
+
+
+}  // namespace pywrap
+
+#endif  // PYWRAP_DRIVER_H_
@@ -0,0 +1,41 @@
+#ifndef PYWRAP_EXTRACTED_H_
+#define PYWRAP_EXTRACTED_H_
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace pywrap
+{
+/// Declarations already extracted during a run. It is shared by the translation
+/// units, so they can skip what a preceding one already extracted
+class Extracted
+{
+  public:
+	/// Claims a declaration for a translation unit. The translation unit with the lowest index
+	/// always gets it, whatever the order the workers run in, and the merge keeps its binding
+	/// @param[in] usr Unified symbol resolution of the declaration
+	/// @param[in] unit Index of the translation unit
+	/// @return False if a translation unit with a lower index claimed it already
+	bool claim( const std::string& usr, size_t unit );
+
+	/// @return The number of declarations skipped by translation units which did not claim them
+	size_t get_skipped_decls() const
+	{
+		return skipped_decls;
+	}
+
+  private:
+	std::mutex mutex;
+
+	/// Lowest index of the translation units which claimed a declaration
+	std::unordered_map<std::string, size_t> decls;
+
+	std::atomic<size_t> skipped_decls{ 0 };
+};
+
+
+}  // namespace pywrap
+
+#endif  // PYWRAP_EXTRACTED_H_
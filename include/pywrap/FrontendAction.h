@@ -8,16 +8,52 @@
 #include <clang/Frontend/FrontendAction.h>
 #include <clang/Tooling/Tooling.h>
 
+#include "pywrap/Extracted.h"
+#include "pywrap/Ir.h"
 #include "pywrap/Printer.h"
-
-#include "pywrap/binding/Module.h"
+#include "pywrap/Profile.h"
 
 namespace pywrap
 {
+/// Options affecting the bindings extracted by the frontend action
+struct FrontendOptions
+{
+	/// Only declarations within files matching this regex are exported, if not empty
+	std::string include_path_regex;
+
+	/// Declarations within files matching this regex are not exported, if not empty
+	std::string exclude_path_regex;
+
+	/// Whether the parser skips function bodies, which bindings do not need
+	bool skip_function_bodies = false;
+
+	/// @return A string which changes whenever the options that affect the bindings change
+	std::string get_key() const
+	{
+		return "include=" + include_path_regex + '\n' + "exclude=" + exclude_path_regex + '\n';
+	}
+};
+
+
+/// Translation unit handled by a frontend action within a run
+struct Unit
+{
+	/// Index of the translation unit within the run
+	size_t index = 0;
+
+	/// Declarations already claimed during the run, if shared
+	Extracted* extracted = nullptr;
+
+	/// Profile to fill, if the run is timed
+	UnitProfile* profile = nullptr;
+};
+
+
 class FrontendAction : public clang::ASTFrontendAction
 {
   public:
-	FrontendAction( std::unordered_map<std::string, binding::Module>& m ) : modules{ m }
+	FrontendAction( ir::Modules& m, std::vector<std::string>& d, const FrontendOptions& o, const Unit& u = {} )
+	    : modules{ m }, dependencies{ d }, options{ o }, unit{ u }
 	{
 	}
 
@@ -33,9 +69,19 @@ class FrontendAction : public clang::ASTFrontendAction
 	/// Starts handling a source file
 	bool BeginSourceFileAction( clang::CompilerInstance& compiler ) override;
 
+	/// Collects the files read while handling the source file
+	void EndSourceFileAction() override;
+
   private:
-	/// Map to be populated by the consumer
-	std::unordered_map<std::string, binding::Module>& modules;
+	/// Map to be populated by the consumer, which converts its bindings before the AST goes away
+	ir::Modules& modules;
+
+	/// Files read by the translation units
+	std::vector<std::string>& dependencies;
+
+	const FrontendOptions& options;
+
+	Unit unit;
 
 	std::vector<std::string> global_includes;
 };
@@ -45,19 +91,37 @@ class FrontendAction : public clang::ASTFrontendAction
 class FrontendActionFactory : public clang::tooling::FrontendActionFactory
 {
   public:
+	/// @param[in] o Options of the actions
+	/// @param[in] u Translation unit within the run
+	FrontendActionFactory( const FrontendOptions& o = {}, const Unit& u = {} ) : options{ o }, unit{ u }
+	{
+	}
+
 	FrontendAction* create() override
 	{
-		return new FrontendAction{ modules };
+		return new FrontendAction{ modules, dependencies, options, unit };
 	}
 
-	/// @return The modules created by the action
-	std::unordered_map<std::string, binding::Module>& get_modules()
+	/// @return The modules extracted by the actions, which do not refer to their ASTs
+	ir::Modules& get_modules()
 	{
 		return modules;
 	};
 
+	/// @return The files read by the action, relative to the working directory of the compile command
+	const std::vector<std::string>& get_dependencies() const
+	{
+		return dependencies;
+	}
+
   private:
-	std::unordered_map<std::string, binding::Module> modules;
+	FrontendOptions options;
+
+	Unit unit;
+
+	ir::Modules modules;
+
+	std::vector<std::string> dependencies;
 };
 
 
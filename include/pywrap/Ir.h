@@ -0,0 +1,215 @@
+#ifndef PYWRAP_IR_H_
+#define PYWRAP_IR_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/raw_ostream.h>
+
+namespace pywrap
+{
+namespace binding
+{
+class Module;
+}  // namespace binding
+
+/// Intermediate representation of the generated bindings. It is made of plain values
+/// which do not refer to clang objects, therefore it can outlive the AST and be stored.
+/// Bindings describe their declarations, from which the printer renders registrations, method entries
+/// and wrapper declarations. Bodies, which need the types of clang to convert values, are rendered
+/// during extraction, so a change to them changes the IR as well and stored IR files must be extracted again
+namespace ir
+{
+/// Kind of a generated binding
+enum class Kind : uint8_t
+{
+	Function,
+	Enum,
+	Template,
+	Specialization,
+	Record,
+	Field,
+	Converter
+};
+
+
+/// @return The lower case name of a kind
+const char* to_string( Kind kind );
+
+
+/// Declaration of a function, enum, template, specialization, record, field or converter, with its generated code
+struct Binding
+{
+	Kind kind = Kind::Function;
+
+	/// Unique id used to discard duplicates
+	std::string id;
+
+	/// Original name
+	std::string name;
+
+	/// Qualified name, with the template arguments of a specialization
+	std::string qualified_name;
+
+	/// Python name, which prefixes the names of the generated symbols
+	std::string py_name;
+
+	/// Return type of a function, or type of a field
+	std::string type;
+
+	/// Parameter types of a function
+	std::vector<std::string> params;
+
+	/// Constants of an enum
+	std::vector<std::string> constants;
+
+	/// Template arguments of a specialization
+	std::vector<std::string> args;
+
+	/// Relative path to the header
+	std::string incl;
+
+	/// Declarations which go within extern "C"
+	std::string decl;
+
+	/// Definitions
+	std::string def;
+
+	/// Accessors of the fields of a record
+	std::vector<Binding> fields;
+
+	/// Cases of the __class_getitem__ of a template, one per specialization, which
+	/// follow its definition. Merging a template adds the cases of every translation unit
+	std::vector<Binding> items;
+};
+
+
+/// Positions of the elements of a vector by id
+using Index = std::unordered_map<std::string, size_t>;
+
+
+/// Positions of the nested modules and of the bindings of a module, so merging does not scan them.
+/// They are not stored, and they are rebuilt whenever they do not cover their vector
+struct Indexes
+{
+	Index modules;
+
+	Index functions;
+
+	Index enums;
+
+	Index templates;
+
+	Index specializations;
+
+	Index records;
+
+	Index converters;
+};
+
+
+/// Generated code of a Python module
+struct Module
+{
+	std::string id;
+
+	/// Original name
+	std::string name;
+
+	/// Python name
+	std::string py_name;
+
+	/// Whether it is registered to a parent module
+	bool nested = false;
+
+	/// Init function declaration
+	std::string decl;
+
+	/// Module definition, without the registrations of its bindings
+	std::string def;
+
+	/// Opening of the methods map
+	std::string methods;
+
+	std::vector<Module> modules;
+
+	std::vector<Binding> functions;
+
+	std::vector<Binding> enums;
+
+	std::vector<Binding> templates;
+
+	std::vector<Binding> specializations;
+
+	std::vector<Binding> records;
+
+	/// Helpers converting the composite types used by the bindings, shared across modules by id
+	std::vector<Binding> converters;
+
+	Indexes indexes;
+};
+
+
+/// Map of global id of the DeclContext and the associated Module,
+/// ordered so that iterating it does not depend on the standard library
+using Modules = std::map<std::string, Module>;
+
+
+/// @param[in] modules Modules produced by the match handler
+/// @return The intermediate representation of the modules
+Modules from_bindings( const std::unordered_map<std::string, binding::Module>& modules );
+
+
+/// Merges modules into another map, keeping the bindings already present
+/// @param[in] into Map of modules to merge into
+/// @param[in] from Modules to merge
+void merge( Modules& into, Modules&& from );
+
+
+/// Sorts nested modules and bindings by id, so the outputs do not depend on
+/// the order of the sources nor on which translation unit extracted a binding first
+/// @param[in] modules Modules to sort
+void sort( Modules& modules );
+
+
+/// Writes modules in a compact binary form
+/// @param[in] os Output stream
+/// @param[in] modules Modules to write
+void write( llvm::raw_ostream& os, const Modules& modules );
+
+
+/// Reads modules written by @ref write, merging them into a map
+/// @param[in] data Binary data, advanced past the modules
+/// @param[out] modules Map to populate
+/// @return False if data is malformed
+bool read( llvm::StringRef& data, Modules& modules );
+
+
+/// Writes modules in a human readable JSON form
+/// @param[in] os Output stream
+/// @param[in] modules Modules to write
+void write_json( llvm::raw_ostream& os, const Modules& modules );
+
+
+/// Writes an IR file
+/// @param[in] path Path of the file
+/// @param[in] modules Modules to write
+/// @return False if the file could not be written
+bool write_file( const std::string& path, const Modules& modules );
+
+
+/// Reads an IR file written by @ref write_file, merging its modules into a map
+/// @param[in] path Path of the file
+/// @param[out] modules Map to populate
+/// @return False if the file could not be read or is malformed
+bool read_file( const std::string& path, Modules& modules );
+
+
+}  // namespace ir
+}  // namespace pywrap
+
+#endif  // PYWRAP_IR_H_
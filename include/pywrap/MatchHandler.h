@@ -1,9 +1,11 @@
 #pragma once
 
 #include <string>
+#include <unordered_set>
 
 #include <clang/AST/Decl.h>
 #include <clang/ASTMatchers/ASTMatchFinder.h>
+#include <llvm/ADT/DenseMap.h>
 
 #include "pywrap/FrontendAction.h"
 #include "pywrap/Util.h"
@@ -16,8 +18,11 @@ class MatchHandler : public clang::ast_matchers::MatchFinder::MatchCallback
 {
   public:
 	/// @brief Constructs the handler for a Pyspot class match
-	/// @param[in] modules Map to populate with modules
-	MatchHandler( std::unordered_map<std::string, binding::Module>& m, FrontendAction& );
+	/// @param[in] m Map to populate with modules
+	/// @param[in] u Translation unit within the run
+	/// @param[in] i Include directories, which are removed from the paths of the headers
+	MatchHandler( std::unordered_map<std::string, binding::Module>& m, const Unit& u,
+	              const std::vector<std::string>& i );
 
 	/// @brief Handles a match
 	/// @param[in] result Match result for pyspot attribute
@@ -31,18 +36,19 @@ class MatchHandler : public clang::ast_matchers::MatchFinder::MatchCallback
 	/// @param[in] decl A Decl which can be a variable, a function, a struct, ...
 	void generate_bindings( const clang::Decl& decl );
 
-	/// @brief Generate python bindings for a @ref clang::FunctionDecl
-	/// @param function A FunctionDecl to wrap
-	void generate_function_bindings( const clang::FunctionDecl* function );
-
   private:
+	/// Claims a declaration for this translation unit, when the run shares extracted declarations
+	/// @param[in] decl Declaration to claim
+	/// @return False if a preceding translation unit already claimed it
+	bool claim( const clang::Decl& decl );
+
 	/// Creates a module for the context if it does not already exist
 	/// @param[in] ctx Declaration context to become a module
 	binding::Module& get_module( const clang::DeclContext& ctx );
 
 	/// @param[in] decl Decl we want to get the path
-	/// @return A proper include path
-	std::string get_include_path( const clang::Decl& decl );
+	/// @return A proper include path, resolved once for every file
+	const std::string& get_include_path( const clang::Decl& decl );
 
 	/// Generates a binding instance
 	/// @param[in] decl The decl to wrap
@@ -55,8 +61,25 @@ class MatchHandler : public clang::ast_matchers::MatchFinder::MatchCallback
 
 	clang::ASTContext* context = nullptr;
 
-	/// Frontend observer to notify as we process classes
-	FrontendAction& frontend;
+	/// Translation unit within the run
+	Unit unit;
+
+	/// Include directories of the translation unit
+	const std::vector<std::string>& global_includes;
+
+	/// Include directories without trailing slashes, looked up by every parent directory of a file
+	std::unordered_set<std::string> include_dirs;
+
+	/// Include paths of the files already resolved
+	llvm::DenseMap<clang::FileID, std::string> include_paths;
+
+	/// Ids of declarations claimed by preceding translation units, so their
+	/// overloads and redeclarations are skipped as well
+	std::unordered_set<std::string> skipped_functions;
+
+	std::unordered_set<std::string> skipped_enums;
+
+	std::unordered_set<std::string> skipped_records;
 };
 
 
@@ -0,0 +1,45 @@
+#ifndef PYWRAP_PATH_FILTER_H_
+#define PYWRAP_PATH_FILTER_H_
+
+#include <string>
+
+#include <clang/Basic/SourceManager.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/Support/Regex.h>
+
+namespace pywrap
+{
+/// Selects the files whose declarations are exported. System headers are always
+/// skipped, other files are selected by regular expressions over their path
+class PathFilter
+{
+  public:
+	/// @param[in] include Only files matching it are selected, every file if empty
+	/// @param[in] exclude Files matching it are not selected, none if empty
+	PathFilter( const std::string& include = "", const std::string& exclude = "" );
+
+	/// @param[in] sources Source manager of the translation unit
+	/// @param[in] location Location of a declaration
+	/// @return Whether declarations at this location are exported
+	bool accepts( const clang::SourceManager& sources, clang::SourceLocation location );
+
+  private:
+	/// @return Whether declarations within this file are exported
+	bool accepts_file( const clang::SourceManager& sources, clang::FileID file );
+
+	llvm::Regex include;
+
+	llvm::Regex exclude;
+
+	bool has_include = false;
+
+	bool has_exclude = false;
+
+	/// Result for every file already checked
+	llvm::DenseMap<clang::FileID, bool> results;
+};
+
+
+}  // namespace pywrap
+
+#endif  // PYWRAP_PATH_FILTER_H_
@@ -0,0 +1,67 @@
+#ifndef PYWRAP_PCH_H_
+#define PYWRAP_PCH_H_
+
+#include <string>
+#include <vector>
+
+#include <clang/Tooling/CompilationDatabase.h>
+
+namespace pywrap
+{
+/// Precompiled header of a prefix included first by every translation unit of a run.
+/// It is built once and loaded by every translation unit instead of parsing the prefix again
+class Pch
+{
+  public:
+	/// @param[in] header Header included first by every translation unit
+	/// @param[in] dir Directory where precompiled headers are kept across runs, a temporary file is used if empty
+	Pch( std::string header, std::string dir = "" );
+
+	/// Removes the precompiled header, if temporary
+	~Pch();
+
+	Pch( const Pch& ) = delete;
+
+	Pch& operator=( const Pch& ) = delete;
+
+	/// Builds the precompiled header, unless an up to date one was kept by a previous run
+	/// @param[in] command Compile command of a translation unit, whose options are used for the header
+	/// @return False if it could not be built
+	bool build( const clang::tooling::CompileCommand& command );
+
+	/// @return The path of the precompiled header
+	const std::string& get_path() const
+	{
+		return path;
+	}
+
+	/// @return Absolute paths of the files the precompiled header was built from
+	const std::vector<std::string>& get_dependencies() const
+	{
+		return dependencies;
+	}
+
+  private:
+	/// @return The command line building the precompiled header into a file
+	std::vector<std::string> get_command_line( const clang::tooling::CompileCommand& command,
+	                                           const std::string& output ) const;
+
+	/// Loads the dependencies of a kept precompiled header
+	/// @return False if it does not exist or any of its dependencies changed
+	bool load();
+
+	/// Header to precompile
+	std::string header;
+
+	/// Directory of kept precompiled headers, none are kept if empty
+	std::string dir;
+
+	std::string path;
+
+	std::vector<std::string> dependencies;
+};
+
+
+}  // namespace pywrap
+
+#endif  // PYWRAP_PCH_H_
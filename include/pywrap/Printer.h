@@ -1,16 +1,29 @@
 #pragma once
+#include <algorithm>
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
 
 #include <clang/Tooling/Tooling.h>
 
-#include <pywrap/binding/Module.h>
+#include "pywrap/Ir.h"
 
 namespace pywrap
 {
 class Printer
 {
   public:
+	/// Number of symbols with external linkage defined by the generated code, estimated from the generated
+	/// declarations rather than read from the built extension, which pywrap never sees
+	struct Symbols
+	{
+		size_t total = 0;
+
+		/// Symbols left in the dynamic symbol table of the extension
+		size_t exported = 0;
+	};
+
 	/// Adds an include path to the set of processed ones
 	/// @param[in] include Include path
 	void add_include( const std::string& include )
@@ -18,49 +31,174 @@ class Printer
 		processed_includes.emplace( include );
 	}
 
+	/// Splits the bindings source into shards, assigning bindings by the hash of their id
+	/// @param[in] count Number of shards, 1 generates a single source
+	void set_shards( unsigned count )
+	{
+		shard_count = std::max( count, 1u );
+	}
+
+	/// Splits the bindings source into a shard per module
+	/// @param[in] by_module Whether to shard by module
+	void set_shard_by_module( bool by_module )
+	{
+		shard_by_module = by_module;
+	}
+
+	/// Gives hidden visibility to the generated symbols, exporting only the module init functions
+	/// @param[in] hidden Whether to hide the symbols
+	void set_hidden_symbols( bool hidden )
+	{
+		hidden_symbols = hidden;
+	}
+
 	/// @brief Finishes handling the files
-	void print_out( const std::unordered_map<std::string, binding::Module>& modules );
+	void print_out( const ir::Modules& modules );
+
+	/// @return The outputs of the last print out which were already up to date
+	const std::vector<std::string>& get_unchanged() const
+	{
+		return unchanged;
+	}
+
+	/// @return The outputs of the last print out, in the order they were printed
+	const std::vector<std::string>& get_outputs() const
+	{
+		return outputs;
+	}
+
+	/// @return The estimated symbols defined by the code of the last print out
+	const Symbols& get_symbols() const
+	{
+		return symbols;
+	}
+
+	/// Prints the declarations of the constructors of the Wrapper specialization of a tag
+	/// @param[in] os Output stream
+	/// @param[in] tag Enum, specialization or record
+	static void print_wrapper_decl( llvm::raw_ostream& os, const ir::Binding& tag );
+
+	/// Prints the registration of a tag to the init function of its module
+	/// @param[in] os Output stream
+	/// @param[in] module Module of the tag
+	/// @param[in] tag Enum, template, specialization or record
+	static void print_reg( llvm::raw_ostream& os, const ir::Module& module, const ir::Binding& tag );
+
+	/// Prints the entry of a function in the methods map of its module
+	/// @param[in] os Output stream
+	/// @param[in] function Function of the module
+	static void print_method( llvm::raw_ostream& os, const ir::Binding& function );
+
+	/// Prints the creation of a nested module and its registration to its parent
+	/// @param[in] os Output stream
+	/// @param[in] parent Module to register to
+	/// @param[in] module Nested module
+	static void print_module_reg( llvm::raw_ostream& os, const ir::Module& parent, const ir::Module& module );
 
   private:
+	/// Function printing the contents of an output file
+	using PrintFunc = void ( Printer::* )( llvm::raw_ostream&, llvm::StringRef );
+
+	/// @brief Streams an output file to disk, replacing the existing one only if its contents changed
+	/// @param[in] name Path of the output file
+	/// @param[in] print Function printing the contents of the file
+	void print_file( llvm::StringRef name, PrintFunc print );
+
+	/// @brief Prints the bindings source, or a shard of it for every module or hash bucket
+	/// @return The paths of the printed sources
+	std::set<std::string> print_bindings_sources();
+
+	/// @brief Removes bindings sources which were not printed
+	/// @param[in] printed Paths of the printed sources
+	void remove_stale_sources( const std::set<std::string>& printed );
+
+	/// @param[in] module Module of the binding
+	/// @param[in] binding Binding to check
+	/// @return Whether the binding belongs to the shard being printed
+	bool in_shard( const ir::Module& module, const ir::Binding& binding ) const;
+
+	/// @brief Atomically replaces a file, unless it already has the contents of the new one
+	/// @param[in] name Path of the output file
+	/// @param[in] temp Path of the new file, which is moved or removed
+	void replace_if_changed( llvm::StringRef name, llvm::StringRef temp );
+
 	/// @brief Prints bindings header
+	/// @param[in] file The output stream
 	/// @param[in] name Path of the output file
-	void print_bindings_header( llvm::StringRef name );
+	void print_bindings_header( llvm::raw_ostream& file, llvm::StringRef name );
 
 	/// @brief Prints bindings source
+	/// @param[in] file The output stream
 	/// @param[in] name Path of the output file
-	void print_bindings_source( llvm::StringRef name );
+	void print_bindings_source( llvm::raw_ostream& file, llvm::StringRef name );
 
 	/// @brief Prints extension header
+	/// @param[in] file The output stream
 	/// @param[in] name Path of the output file
-	void print_extension_header( llvm::StringRef name );
+	void print_extension_header( llvm::raw_ostream& file, llvm::StringRef name );
 
 	/// @brief Prints extension source
+	/// @param[in] file The output stream
 	/// @param[in] name Path of the output file
-	void print_extension_source( llvm::StringRef name );
+	void print_extension_source( llvm::raw_ostream& file, llvm::StringRef name );
 
 	/// Recursively process includes for a module and its submodules
 	/// @param[in] file The current output stream
 	/// @param[in] module The current module to process
-	void process_includes( llvm::raw_fd_ostream& file, const binding::Module& module );
+	void process_includes( llvm::raw_ostream& file, const ir::Module& module );
 
 	/// Recursively process declarations for a module and its submodules
 	/// @param[in] file The current output stream
 	/// @param[in] module The current module to process
-	void process_decls( llvm::raw_fd_ostream& file, const binding::Module& module );
+	void process_decls( llvm::raw_ostream& file, const ir::Module& module );
 
 	/// Recursively process wrappers for a module and its submodules
 	/// @param[in] file The current output stream
 	/// @param[in] module The current module to process
-	void process_wrappers( llvm::raw_fd_ostream& file, const binding::Module& module );
+	void process_wrappers( llvm::raw_ostream& file, const ir::Module& module );
 
 	/// Recursively process definitions for a module and its submodules
 	/// @param[in] file The current output stream
 	/// @param[in] module The current module to process
-	void process_defs( llvm::raw_fd_ostream& file, const binding::Module& module );
+	void process_defs( llvm::raw_ostream& file, const ir::Module& module );
+
+	/// Prints the registrations of the bindings of a module
+	/// @param[in] file The current output stream
+	/// @param[in] module The module to register bindings to
+	void process_regs( llvm::raw_ostream& file, const ir::Module& module );
+
+	/// Recursively collects the converters of a module and its submodules, keeping the first module using each one
+	/// @param[in] module The current module to process
+	void collect_converters( const ir::Module& module );
+
+	/// Recursively counts the symbols defined for a module and its submodules, excluding the module init function
+	/// @param[in] module The current module to process
+	void count_symbols( const ir::Module& module );
 
-	const std::unordered_map<std::string, binding::Module>* modules;
+	const ir::Modules* modules;
 
 	std::set<std::string> processed_includes;
+
+	/// Converters by id, along with the first module using them, which defines them when sharding by module
+	std::map<std::string, std::pair<const ir::Binding*, const ir::Module*>> converters;
+
+	std::vector<std::string> unchanged;
+
+	std::vector<std::string> outputs;
+
+	unsigned shard_count = 1;
+
+	bool shard_by_module = false;
+
+	bool hidden_symbols = false;
+
+	Symbols symbols;
+
+	/// Index of the shard being printed
+	unsigned shard = 0;
+
+	/// Id of the module of the shard being printed
+	std::string shard_module;
 };
 
 
@@ -0,0 +1,200 @@
+#ifndef PYWRAP_PROFILE_H_
+#define PYWRAP_PROFILE_H_
+
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <llvm/Support/raw_ostream.h>
+
+#include "pywrap/Ir.h"
+
+namespace pywrap
+{
+/// Wall and CPU time, in seconds
+struct Time
+{
+	/// @return Current wall time and CPU time of the calling thread
+	static Time now();
+
+	Time& operator+=( const Time& o )
+	{
+		wall += o.wall;
+		cpu += o.cpu;
+		return *this;
+	}
+
+	Time operator-( const Time& o ) const
+	{
+		return { wall - o.wall, cpu - o.cpu };
+	}
+
+	double wall = 0.0;
+
+	double cpu = 0.0;
+};
+
+
+/// @return The peak resident memory of the process in bytes, 0 if unknown
+size_t get_peak_memory();
+
+
+/// Adds the time spent within a scope to a Time, if any
+class ScopedTime
+{
+  public:
+	/// @param[in] t Time to add to, nothing is measured if null
+	ScopedTime( Time* t ) : time{ t }, start{ t ? Time::now() : Time{} }
+	{
+	}
+
+	~ScopedTime()
+	{
+		if ( time )
+		{
+			*time += Time::now() - start;
+		}
+	}
+
+
+  private:
+	Time* time = nullptr;
+
+	Time start;
+};
+
+
+/// Profile of a translation unit
+struct UnitProfile
+{
+	std::string source;
+
+	/// Whether the bindings came from the cache
+	bool cached = false;
+
+	/// Whole processing of the translation unit
+	Time total;
+
+	/// Frontend action, including matching and conversion to IR
+	Time frontend;
+
+	/// Matching, including binding construction
+	Time match;
+
+	/// Construction of the bindings
+	Time bindings;
+
+	/// Conversion of the bindings to IR, within the frontend action
+	Time convert;
+
+	/// Cache and IR files
+	Time ir;
+
+	/// Declarations matched
+	size_t matched_decls = 0;
+
+	/// Bindings constructed
+	size_t generated_bindings = 0;
+
+	/// Time spent within every header, excluding the headers it includes
+	std::unordered_map<std::string, Time> headers;
+};
+
+
+/// Time report of a run
+class TimeReport
+{
+  public:
+	/// @param[in] name Name of a phase of the run
+	/// @return The time of the phase, which is added the first time it is requested
+	Time& get_phase( const std::string& name );
+
+	/// @return The profiles of the translation units, following the order of the sources
+	std::vector<UnitProfile>& get_units()
+	{
+		return units;
+	}
+
+	/// Prints the report in a human readable form
+	/// @param[in] os Output stream
+	/// @param[in] slowest Number of slowest translation units and headers to list
+	void print( llvm::raw_ostream& os, size_t slowest = 10 ) const;
+
+	/// Prints the report in JSON form
+	/// @param[in] os Output stream
+	/// @param[in] slowest Number of slowest translation units and headers to list
+	void print_json( llvm::raw_ostream& os, size_t slowest = 10 ) const;
+
+  private:
+	/// @return The translation units sorted by decreasing wall time, up to a count
+	std::vector<const UnitProfile*> get_slowest_units( size_t count ) const;
+
+	/// @return The headers sorted by decreasing wall time summed over every translation unit, up to a count
+	std::vector<std::pair<std::string, Time>> get_slowest_headers( size_t count ) const;
+
+	/// Phases of the run, in order of appearance
+	std::vector<std::pair<std::string, Time>> phases;
+
+	std::vector<UnitProfile> units;
+};
+
+
+/// Approximate memory held by a number of bindings
+struct MemoryUsage
+{
+	size_t count = 0;
+
+	size_t bytes = 0;
+};
+
+
+/// Memory report of a run
+class MemoryReport
+{
+  public:
+	/// @param[in] largest Number of largest bindings to list
+	MemoryReport( size_t largest = 10 ) : largest_count{ largest }
+	{
+	}
+
+	/// Records the peak memory of the process at the end of a phase of the run
+	/// @param[in] name Name of the phase
+	void add_phase( const std::string& name );
+
+	/// Accounts the memory held by the bindings of modules
+	/// @param[in] modules Modules to account
+	void add_modules( const ir::Modules& modules );
+
+	/// Prints the report in a human readable form
+	/// @param[in] os Output stream
+	void print( llvm::raw_ostream& os ) const;
+
+  private:
+	void add_module( const ir::Module& module );
+
+	/// @return The bytes held by a binding, excluding its fields
+	size_t add_binding( const ir::Binding& binding );
+
+	/// Keeps a binding if it is one of the largest
+	void add_largest( const ir::Binding& binding, size_t bytes );
+
+	size_t largest_count = 10;
+
+	/// Peak memory at the end of every phase, in order of appearance
+	std::vector<std::pair<std::string, size_t>> phases;
+
+	MemoryUsage modules;
+
+	/// Usage of every binding kind
+	std::array<MemoryUsage, static_cast<size_t>( ir::Kind::Converter ) + 1> kinds;
+
+	/// Largest bindings, including their fields, as a min-heap by bytes
+	std::vector<std::pair<size_t, std::string>> largest;
+};
+
+
+}  // namespace pywrap
+
+#endif  // PYWRAP_PROFILE_H_
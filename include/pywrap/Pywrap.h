@@ -8,8 +8,11 @@
 #include <llvm/Support/FileSystem.h>
 
 #include "pywrap/Consumer.h"
+#include "pywrap/Driver.h"
 #include "pywrap/FrontendAction.h"
 #include "pywrap/Printer.h"
+#include "pywrap/SizeReport.h"
 #include "pywrap/Util.h"
+#include "pywrap/Watcher.h"
 
 #endif  // PYSPOT_PYWRAP_H_
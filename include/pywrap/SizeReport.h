@@ -0,0 +1,107 @@
+#ifndef PYWRAP_SIZE_REPORT_H_
+#define PYWRAP_SIZE_REPORT_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <llvm/Support/raw_ostream.h>
+
+#include "pywrap/Ir.h"
+
+namespace pywrap
+{
+/// Code generated for a module or a binding, and the time spent compiling it
+struct CodeSize
+{
+	/// Id of the module or the binding
+	std::string id;
+
+	/// Kind of the binding, or module
+	std::string kind;
+
+	/// Id of the module of the binding, empty for a module
+	std::string module;
+
+	size_t bytes = 0;
+
+	size_t lines = 0;
+
+	/// Frontend time attributed by time traces, in seconds
+	double frontend = 0.0;
+
+	/// Backend time attributed by time traces, in seconds
+	double backend = 0.0;
+};
+
+
+/// Report of the code generated for every module, record, field, function, specialization and converter,
+/// optionally attributing to them the time spent compiling the generated sources
+class SizeReport
+{
+  public:
+	/// @param[in] largest Number of largest and slowest bindings to list
+	SizeReport( size_t largest = 20 ) : largest_count{ largest }
+	{
+	}
+
+	/// Accounts the code generated for modules
+	/// @param[in] modules Modules to account
+	void add_modules( const ir::Modules& modules );
+
+	/// Attributes the events of a Clang time trace to the bindings whose generated symbols they refer to
+	/// @param[in] path Time trace written by -ftime-trace
+	/// @return False if it could not be read
+	bool add_time_trace( const std::string& path );
+
+	/// Prints the report in a human readable form
+	/// @param[in] os Output stream
+	void print( llvm::raw_ostream& os ) const;
+
+	/// Prints the report in JSON form, listing every binding
+	/// @param[in] os Output stream
+	void print_json( llvm::raw_ostream& os ) const;
+
+  private:
+	/// Accounts the code generated for a module, its nested modules and its bindings
+	/// @param[in] module Module to account
+	/// @param[in] parent Module the module is registered to, if nested
+	void add_module( const ir::Module& module, const ir::Module* parent = nullptr );
+
+	/// Accounts the code generated for a binding, excluding its fields
+	/// @param[in] module Module of the binding
+	/// @param[in] binding Binding to account
+	/// @param[in] symbol Generated symbol, or the prefix shared by the generated symbols of the binding
+	/// @return Index of the entry of the binding
+	size_t add_binding( const ir::Module& module, const ir::Binding& binding, const std::string& symbol );
+
+	/// @param[in] prefix A generated symbol or the prefix shared by the symbols of an entry
+	/// @param[in] index Index of the entry within the sizes
+	void add_symbol( const std::string& prefix, size_t index );
+
+	/// @param[in] detail Detail of a time trace event
+	/// @return The entry generating the symbol with the longest match within the detail, nullptr if none
+	CodeSize* find_entry( llvm::StringRef detail );
+
+	/// @param[in] count Maximum number of entries
+	/// @param[in] key Key of the entries to compare
+	/// @return The bindings with the highest keys, excluding modules
+	template <typename Key>
+	std::vector<const CodeSize*> get_largest( size_t count, Key key ) const;
+
+	size_t largest_count = 20;
+
+	/// Modules followed by their bindings
+	std::vector<CodeSize> sizes;
+
+	/// Index of the entries by generated symbol, or by the prefix of their symbols
+	std::unordered_map<std::string, size_t> symbols;
+
+	/// Number of time traces attributed
+	size_t traces = 0;
+};
+
+
+}  // namespace pywrap
+
+#endif  // PYWRAP_SIZE_REPORT_H_
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <clang/AST/ASTContext.h>
 #include <clang/AST/Decl.h>
@@ -31,6 +32,11 @@ static ConstIterator<Container> find( const Container& container, const Type& va
 void replace_all( std::string& str, const llvm::StringRef& from, const llvm::StringRef& to );
 
 
+/// @param[in] entry A file read by the frontend
+/// @return The real path of the file when available, with / separators
+std::string get_path( const clang::FileEntry& entry );
+
+
 std::string replace_all( const std::string& str, const llvm::StringRef& from, const llvm::StringRef& to );
 
 
@@ -45,13 +51,60 @@ std::string to_string( const clang::QualType& type, const TemplateMap& tMap, con
 clang::QualType to_type( const clang::QualType& type, const TemplateMap& tMap );
 
 
-std::string to_python( const clang::QualType& type, std::string name );
+/// Named helper converting values of a composite type between C++ and Python
+struct Converter
+{
+	/// Name of the helper, unique to the canonical type and the direction of the conversion
+	std::string name;
+
+	/// Spelling of the canonical type
+	std::string type;
+
+	/// Declaration of the helper
+	std::string decl;
+
+	/// Definition of the helper
+	std::string def;
+};
+
+
+/// Helpers converting standard containers, generated once per canonical type. Getters, setters
+/// and functions call them instead of inlining a loop at every use of the type
+class Converters
+{
+  public:
+	/// @param[in] type A std::vector or a std::map
+	/// @return The name of the helper converting a value of the type to a new Python object
+	const std::string& to_python( const clang::QualType& type );
+
+	/// @param[in] type A std::map
+	/// @return The name of the helper converting a Python object to a value of the type
+	const std::string& to_c( const clang::QualType& type );
+
+	/// @return The helpers, each one after the helpers it calls
+	const std::vector<Converter>& get_converters() const
+	{
+		return converters;
+	}
+
+  private:
+	/// Names of the helpers to Python by canonical type
+	std::unordered_map<const clang::Type*, std::string> python_names;
+
+	/// Names of the helpers to C++ by canonical type
+	std::unordered_map<const clang::Type*, std::string> c_names;
+
+	std::vector<Converter> converters;
+};
+
+
+std::string to_python( const clang::QualType& type, std::string name, Converters& converters );
 
 
 std::string to_python( const clang::QualType& type, const std::string& name, const TemplateMap& tMap,
                        const clang::ASTContext& ctx );
 
-std::string to_c( const clang::QualType& type, std::string name, std::string dest );
+std::string to_c( const clang::QualType& type, std::string name, std::string dest, Converters& converters );
 
 
 std::string to_py_parser( const clang::QualType& type );
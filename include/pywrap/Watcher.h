@@ -0,0 +1,49 @@
+#ifndef PYWRAP_WATCHER_H_
+#define PYWRAP_WATCHER_H_
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace pywrap
+{
+/// Watches a set of files for changes. The directories of the files are watched,
+/// so files replaced by editors or build tools through a rename are still noticed
+class Watcher
+{
+  public:
+	Watcher();
+
+	~Watcher();
+
+	Watcher( const Watcher& ) = delete;
+
+	Watcher& operator=( const Watcher& ) = delete;
+
+	/// @return Whether files can be watched on this platform
+	static bool is_supported();
+
+	/// Replaces the watched files
+	/// @param[in] paths Absolute paths of the files to watch
+	/// @return False if they could not be watched
+	bool watch( const std::vector<std::string>& paths );
+
+	/// Blocks until any watched file changes, then waits for the changes to settle
+	/// @return Absolute paths of the changed files, empty on failure
+	std::vector<std::string> wait();
+
+  private:
+	/// Inotify instance, -1 if none
+	int fd = -1;
+
+	/// Map of watch descriptor and the associated directory
+	std::unordered_map<int, std::string> dirs;
+
+	std::unordered_set<std::string> files;
+};
+
+
+}  // namespace pywrap
+
+#endif  // PYWRAP_WATCHER_H_
@@ -1,9 +1,13 @@
 #ifndef PYWRAP_BINDING_H_
 #define PYWRAP_BINDING_H_
 
-#include <sstream>
+#include <string>
 
 #include <clang/AST/Decl.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "pywrap/Util.h"
+#include "pywrap/binding/Text.h"
 
 namespace pywrap
 {
@@ -26,7 +30,8 @@ class Binding
 		return id;
 	}
 
-	/// Initializes the members
+	/// Initializes the names and the signature of the binding.
+	/// The declaration and the definition are rendered while printing, straight into the output stream
 	virtual void init();
 
 	/// @return The relative path to the header
@@ -36,39 +41,47 @@ class Binding
 	}
 
 	/// @return The original name
-	std::string get_name() const
+	const std::string& get_name() const
 	{
 		return name.str();
 	}
 
 	/// @return The qualified name
-	std::string get_qualified_name() const
+	const std::string& get_qualified_name() const
 	{
 		return qualified_name.str();
 	}
 
 	/// @return The python name
-	std::string get_py_name() const
+	const std::string& get_py_name() const
 	{
 		return py_name.str();
 	}
 
 	/// @return The signature of the binding
-	std::string get_sign() const
+	const std::string& get_sign() const
 	{
 		return sign.str();
 	}
 
 	/// @return The declaration of the binding
-	virtual std::string get_decl() const
+	std::string get_decl() const;
+
+	/// @return The definition of the binding
+	std::string get_def() const;
+
+	/// Prints the declaration of the binding
+	/// @param[in] os Output stream
+	virtual void print_decl( llvm::raw_ostream& os ) const
 	{
-		return decl.str();
+		gen_decl( os );
 	}
 
-	/// @return The definition of the binding
-	virtual std::string get_def() const
+	/// Prints the definition of the binding
+	/// @param[in] os Output stream
+	virtual void print_def( llvm::raw_ostream& os ) const
 	{
-		return def.str();
+		gen_def( os );
 	}
 
 	/// Generates the relative path to the header
@@ -77,6 +90,12 @@ class Binding
 		incl = i;
 	}
 
+	/// @return The helpers converting the composite types used by the definition
+	const Converters& get_converters() const
+	{
+		return converters;
+	}
+
   protected:
 	/// Generates the name of the binding
 	virtual void gen_name();
@@ -91,18 +110,20 @@ class Binding
 	virtual void gen_sign(){};
 
 	/// Generates the declaration of the bindings
-	virtual void gen_decl();
+	/// @param[in] decl Output stream
+	virtual void gen_decl( llvm::raw_ostream& decl ) const;
 
 	/// Generates the definition of the bindings
-	virtual void gen_def(){};
+	/// @param[in] def Output stream
+	virtual void gen_def( llvm::raw_ostream& def ) const {};
 
 	/// @return A mutable reference to the qualified name
-	std::stringstream& get_mut_qualified_name()
+	Text& get_mut_qualified_name()
 	{
 		return qualified_name;
 	}
 
-	/// Named decl
+	/// Named decl, only valid while its translation unit is being matched
 	const clang::NamedDecl* named{ nullptr };
 
 	/// Qualified name as unique id
@@ -115,22 +136,19 @@ class Binding
 	std::string incl;
 
 	/// Name
-	std::stringstream name;
+	Text name;
 
 	/// Qualified name
-	std::stringstream qualified_name;
+	Text qualified_name;
 
 	/// Python name
-	std::stringstream py_name;
+	Text py_name;
 
 	/// Signature
-	std::stringstream sign;
-
-	/// Declaration
-	std::stringstream decl;
+	Text sign;
 
-	/// Definition
-	std::stringstream def;
+	/// Helpers called by the definition, filled while the definition is printed
+	mutable Converters converters;
 };
 
 }  // namespace binding
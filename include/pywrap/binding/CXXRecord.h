@@ -18,7 +18,7 @@ class CXXRecord : public Tag
 
 	virtual ~CXXRecord() = default;
 
-	CXXRecord( CXXRecord&& ) = default;
+	CXXRecord( CXXRecord&& );
 
 	virtual void gen_fields() override;
 
@@ -33,9 +33,9 @@ class CXXRecord : public Tag
 
 	virtual void init() override;
 
-	virtual std::string get_decl() const override;
+	virtual void print_decl( llvm::raw_ostream& os ) const override;
 
-	virtual std::string get_def() const override;
+	virtual void print_def( llvm::raw_ostream& os ) const override;
 
   private:
 	/// CXXRecord decl
@@ -74,7 +74,7 @@ class Specialization : public CXXRecord
 
 	clang::ArrayRef<clang::TemplateArgument> args;
 
-	std::stringstream template_args;
+	Text template_args;
 };
 
 
@@ -87,19 +87,9 @@ class Template : public Tag
 
 	Template( Template&& ) = default;
 
-	const std::vector<const Specialization*> get_specializations() const
-	{
-		return specializations;
-	}
-
-	/// Adds a specialization to the template
+	/// Adds a specialization to the __class_getitem__ of the template
 	/// @param[in] spec Template specialization to add
 	void add( const Specialization& spec );
-
-  private:
-	const clang::ClassTemplateDecl& templ;
-
-	std::vector<const Specialization*> specializations;
 };
 
 }  // namespace binding
@@ -1,6 +1,8 @@
 #ifndef PYWRAP_BINDING_CLASSGETITEM_H_
 #define PYWRAP_BINDING_CLASSGETITEM_H_
 
+#include <vector>
+
 #include "pywrap/binding/Binding.h"
 
 namespace pywrap
@@ -13,21 +15,57 @@ class Specialization;
 class ClassGetitem : public Binding
 {
   public:
+	/// Case returning the type object of a specialization
+	struct Item
+	{
+		/// Qualified name of the specialization
+		std::string id;
+
+		/// Spelling of the template argument of the specialization
+		std::string arg;
+
+		/// Python name of the type object of the specialization
+		std::string type_object;
+	};
+
 	ClassGetitem( const Tag* t = nullptr ) : tag{ t }
 	{
 	}
 
 	void add( const Specialization& s );
 
-	virtual std::string get_def() const override;
+	/// @return The cases of the specializations, in the order they were added
+	const std::vector<Item>& get_items() const
+	{
+		return items;
+	}
+
+	/// Prints the case of a specialization
+	/// @param[in] os Output stream
+	/// @param[in] item Case to print
+	static void print_item( llvm::raw_ostream& os, const Item& item );
+
+	/// Prints the opening of the definition, up to the cases
+	/// @param[in] os Output stream
+	void print_head( llvm::raw_ostream& os ) const;
+
+	/// Prints the closing of the definition, after the cases
+	/// @param[in] os Output stream
+	void print_tail( llvm::raw_ostream& os ) const;
+
+	virtual void print_def( llvm::raw_ostream& os ) const override;
 
   protected:
 	virtual void gen_py_name() override;
 	virtual void gen_sign() override;
-	virtual void gen_def() override;
+	virtual void gen_def( llvm::raw_ostream& def ) const override;
 
   private:
 	const Tag* tag;
+
+	std::vector<Item> items;
+
+	friend class Tag;
 };
 
 
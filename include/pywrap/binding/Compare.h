@@ -20,13 +20,16 @@ class Compare : public Binding
   protected:
 	void gen_name() override;
 	void gen_sign() override;
-	void gen_def() override;
+	void gen_def( llvm::raw_ostream& def ) const override;
 
   private:
 	/// Generates operator equals
-	void gen_eq();
+	/// @param[in] def Output stream
+	void gen_eq( llvm::raw_ostream& def ) const;
 
 	const Tag* tag;
+
+	friend class Tag;
 };
 
 }  // namespace binding
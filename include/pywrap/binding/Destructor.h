@@ -20,10 +20,12 @@ class Destructor : public Binding
   protected:
 	void gen_name() override;
 	void gen_sign() override;
-	void gen_def() override;
+	void gen_def( llvm::raw_ostream& def ) const override;
 
   private:
-	const Tag& tag;
+	const Tag* tag;
+
+	friend class Tag;
 };
 }  // namespace binding
 }  // namespace pywrap
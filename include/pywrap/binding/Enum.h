@@ -15,9 +15,11 @@ class Enum : public Tag
 	/// @param[in] enu Enum to wrap
 	Enum( const clang::EnumDecl& enu, const Binding& parent );
 
-  protected:
-	/// Generates the registration of the bindings
-	void gen_reg() override;
+	/// @return The clang EnumDecl
+	const clang::EnumDecl& get_enum() const
+	{
+		return enu;
+	}
 
   private:
 	/// Enum decl
@@ -21,7 +21,7 @@ class Getter : public Binding
   protected:
 	virtual void gen_name() override;
 	virtual void gen_sign() override;
-	virtual void gen_def() override;
+	virtual void gen_def( llvm::raw_ostream& def ) const override;
 
   private:
 	const Field* field;
@@ -39,7 +39,7 @@ class Setter : public Binding
 
 	virtual void gen_name() override;
 	virtual void gen_sign() override;
-	virtual void gen_def() override;
+	virtual void gen_def( llvm::raw_ostream& def ) const override;
 
   private:
 	const Field* field;
@@ -70,7 +70,7 @@ class Field
 
 	const Tag& get_tag() const
 	{
-		return tag;
+		return *tag;
 	}
 
 	const std::string& get_name() const
@@ -90,13 +90,16 @@ class Field
   private:
 	const clang::FieldDecl& field;
 
-	const Tag& tag;
+	/// Tag owning the field, updated when the tag is moved
+	const Tag* tag;
 
 	std::string name;
 
 	Getter getter;
 
 	Setter setter;
+
+	friend class CXXRecord;
 };
 
 }  // namespace binding
@@ -1,8 +1,6 @@
 #ifndef PYWRAP_BINDING_FUNCTION_H_
 #define PYWRAP_BINDING_FUNCTION_H_
 
-#include <sstream>
-
 #include <clang/AST/Decl.h>
 
 #include "pywrap/binding/Binding.h"
@@ -31,7 +29,7 @@ class Function : public Binding
 	virtual void gen_sign() override;
 
 	/// Generates the definition of the bindings
-	virtual void gen_def() override;
+	virtual void gen_def( llvm::raw_ostream& def ) const override;
 
   private:
 	/// Function decl
@@ -19,17 +19,18 @@ class Init : public Binding
 	/// @param[in] t Tag which this init belongs to
 	Init( const Tag& );
 
-	std::string get_def() const override;
+	void print_def( llvm::raw_ostream& os ) const override;
 
   protected:
 	void gen_name() override;
 	void gen_sign() override;
-	void gen_def() override;
+	void gen_def( llvm::raw_ostream& def ) const override;
 
   private:
 	/// Adds a constructor to the definition of the initializer
+	/// @param[in] def Output stream
 	/// @param[in] constructor Constructor to support
-	void add_def( const clang::CXXConstructorDecl& constructor );
+	void add_def( llvm::raw_ostream& def, const clang::CXXConstructorDecl& constructor ) const;
 
 	const Tag* tag = nullptr;
 
@@ -25,7 +25,7 @@ class Method : public Binding
 	void gen_sign() override;
 
 	/// Generates the definition of the method bindings
-	void gen_def() override;
+	void gen_def( llvm::raw_ostream& def ) const override;
 
   private:
 	/// CXX method decl
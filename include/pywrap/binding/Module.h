@@ -1,7 +1,8 @@
 #ifndef PYWRAP_BINDINGS_MODULE_H_
 #define PYWRAP_BINDINGS_MODULE_H_
 
-#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <clang/AST/Decl.h>
 
@@ -22,26 +23,14 @@ class Module : public Binding
 	class Methods : public Binding
 	{
 	  public:
-		Methods( const Module& m );
+		/// @param[in] n Namespace of the module
+		Methods( const clang::NamedDecl& n );
 
 		Methods( Methods&& ) = default;
 
-		/// Adds a function to the methods map
-		/// @param f The function to add
-		void add( const Function& f );
-
-		/// @return The definition of the methods map
-		std::string get_def() const override;
-
 	  protected:
-		/// @return The python name of the methods map
-		void gen_py_name() override;
-
-		/// @return Definition of the methods map
-		void gen_def() override;
-
-	  private:
-		const Module& module;
+		/// @return Opening of the methods map, entries are provided by the functions
+		void gen_def( llvm::raw_ostream& def ) const override;
 	};
 
 	/// A module binding consist of an init function declaration
@@ -49,17 +38,12 @@ class Module : public Binding
 
 	Module( Module&& ) = default;
 
-	const clang::NamedDecl* get_handle() const
+	/// @return Whether this module is registered to a parent module
+	bool is_nested() const
 	{
-		return ns;
+		return parent != nullptr;
 	}
 
-	/// @return The module init function definition
-	std::string get_def() const override;
-
-	/// @return The registration to its parent
-	std::string get_reg() const;
-
 	/// Adds a nested module
 	/// @param[in] m The nested module to add
 	void add( Module&& m );
@@ -90,6 +74,28 @@ class Module : public Binding
 		return methods;
 	}
 
+	/// @param[in] id Id of a nested module
+	/// @return The nested module with that id, or nullptr if not found
+	Module* find_child( const std::string& id );
+
+	/// @return Whether a function with this id has been added
+	bool has_function( const std::string& id ) const
+	{
+		return function_ids.count( id ) > 0;
+	}
+
+	/// @return Whether an enum with this id has been added
+	bool has_enum( const std::string& id ) const
+	{
+		return enum_ids.count( id ) > 0;
+	}
+
+	/// @return Whether a record or a template with this id has been added
+	bool has_record( const std::string& id ) const
+	{
+		return record_ids.count( id ) > 0;
+	}
+
 	/// @return The nested modules within this module
 	std::vector<Module>& get_children()
 	{
@@ -136,22 +142,13 @@ class Module : public Binding
 	/// @return A signature of the binding
 	virtual void gen_sign() override;
 
-	/// @return A definition of the bindings
-	virtual void gen_def() override;
-
-	/// @return Registration of this module
-	void gen_reg();
+	/// @return A definition of the module, the init function is closed by the printer
+	virtual void gen_def( llvm::raw_ostream& def ) const override;
 
   private:
-	/// Named decl
-	const clang::NamedDecl* ns = nullptr;
-
 	/// Python MethodDef
 	Methods methods;
 
-	/// Module registration
-	std::stringstream reg;
-
 	/// Module functions
 	std::vector<Module> modules;
 
@@ -169,6 +166,18 @@ class Module : public Binding
 
 	/// Module templates
 	std::vector<Specialization> specializations;
+
+	/// Position of the nested modules by id
+	std::unordered_map<std::string, size_t> module_index;
+
+	/// Ids of the functions
+	std::unordered_set<std::string> function_ids;
+
+	/// Ids of the enums
+	std::unordered_set<std::string> enum_ids;
+
+	/// Ids of the records and templates
+	std::unordered_set<std::string> record_ids;
 };
 
 }  // namespace binding
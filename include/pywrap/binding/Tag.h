@@ -28,15 +28,11 @@ class Tag : public Binding
 
 		Methods( Methods&& ) = default;
 
-		/// Adds a method to the methods map
-		/// @param m The method to add
-		void add( const Method& m );
+		/// Prints the declaration of the methods map
+		virtual void print_decl( llvm::raw_ostream& os ) const override;
 
-		/// @return The declaration of the methods map
-		virtual std::string get_decl() const override;
-
-		/// @return The definition of the methods map
-		virtual std::string get_def() const override;
+		/// Prints the definition of the methods map
+		virtual void print_def( llvm::raw_ostream& os ) const override;
 
 	  protected:
 		/// Generates the python name of the methods map
@@ -46,12 +42,12 @@ class Tag : public Binding
 		void gen_sign() override;
 
 		/// Generates the definition of the methods map
-		void gen_def() override;
+		void gen_def( llvm::raw_ostream& def ) const override;
 
 	  private:
 		const Tag* tag;
 
-		size_t size = 1;
+		friend class Tag;
 	};
 
 	/// This represents a PyMemberDef structure
@@ -63,8 +59,8 @@ class Tag : public Binding
 
 		Members( Members&& ) = default;
 
-		/// @return The declaration of the member map
-		std::string get_decl() const override;
+		/// Prints the declaration of the member map
+		void print_decl( llvm::raw_ostream& os ) const override;
 
 	  protected:
 		/// Generates the python name of the members map
@@ -74,12 +70,12 @@ class Tag : public Binding
 		void gen_sign() override;
 
 		/// Generates the definition of the members map
-		void gen_def() override;
+		void gen_def( llvm::raw_ostream& def ) const override;
 
 	  private:
 		const Tag* tag;
 
-		size_t size = 1;
+		friend class Tag;
 	};
 
 	/// Represents a getset map
@@ -91,8 +87,8 @@ class Tag : public Binding
 
 		Accessors( Accessors&& ) = default;
 
-		/// @return The declaration of the getset map
-		std::string get_decl() const override;
+		/// Prints the declaration of the getset map
+		void print_decl( llvm::raw_ostream& os ) const override;
 
 	  protected:
 		/// Generates the python name of the getset map
@@ -102,13 +98,15 @@ class Tag : public Binding
 		void gen_sign() override;
 
 		/// Generates the definition of the getset map
-		void gen_def() override;
+		void gen_def( llvm::raw_ostream& def ) const override;
 
 	  private:
+		/// @return The number of entries of the getset map, sentinel included
+		size_t get_size() const;
+
 		const Tag* tag = nullptr;
 
-		/// Used for generated array size
-		size_t size = 1;
+		friend class Tag;
 	};
 
 	virtual ~Tag() = default;
@@ -200,34 +198,27 @@ class Tag : public Binding
 		return wrapper;
 	}
 
-	/// @return The declaration
-	virtual std::string get_decl() const override;
+	/// Prints the declaration
+	virtual void print_decl( llvm::raw_ostream& os ) const override;
 
-	/// @return The definition
-	virtual std::string get_def() const override;
+	/// Prints the definition
+	virtual void print_def( llvm::raw_ostream& os ) const override;
 
-	/// @return The registration to the module
-	std::string get_reg() const
-	{
-		return reg.str();
-	}
+	/// Prints the definition, leaving the __class_getitem__ func open for the cases of the specializations
+	/// @param[in] os Output stream
+	void print_open_def( llvm::raw_ostream& os ) const;
 
   protected:
 	virtual void gen_fields()
 	{
 	}
 
-	virtual void gen_reg();
-
 	/// @return The __class_getitem__ func
 	ClassGetitem& get_mut_class_getitem()
 	{
 		return class_getitem;
 	}
 
-	/// Module registration
-	std::stringstream reg;
-
   private:
 	/// Tag decl
 	const clang::TagDecl* tag = nullptr;
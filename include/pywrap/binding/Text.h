@@ -0,0 +1,89 @@
+#ifndef PYWRAP_BINDING_TEXT_H_
+#define PYWRAP_BINDING_TEXT_H_
+
+#include <string>
+#include <type_traits>
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/raw_ostream.h>
+
+namespace pywrap
+{
+namespace binding
+{
+/// Append-only builder of generated code over a std::string, with the << interface of the streams it replaces.
+/// It has no locale or stream buffer per instance, and the text can be read without a copy
+class Text
+{
+  public:
+	Text& operator<<( const llvm::StringRef s )
+	{
+		buffer.append( s.data(), s.size() );
+		return *this;
+	}
+
+	Text& operator<<( const std::string& s )
+	{
+		buffer += s;
+		return *this;
+	}
+
+	Text& operator<<( const char* s )
+	{
+		buffer += s;
+		return *this;
+	}
+
+	Text& operator<<( const char c )
+	{
+		buffer += c;
+		return *this;
+	}
+
+	Text& operator<<( const Text& t )
+	{
+		buffer += t.buffer;
+		return *this;
+	}
+
+	template <typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+	Text& operator<<( const T n )
+	{
+		buffer += std::to_string( n );
+		return *this;
+	}
+
+	/// @return The text built so far
+	const std::string& str() const
+	{
+		return buffer;
+	}
+
+	bool empty() const
+	{
+		return buffer.empty();
+	}
+
+	size_t size() const
+	{
+		return buffer.size();
+	}
+
+  private:
+	std::string buffer;
+};
+
+
+/// Prints the text built so far
+/// @param[in] os Output stream
+/// @param[in] t Text to print
+/// @return The output stream
+inline llvm::raw_ostream& operator<<( llvm::raw_ostream& os, const Text& t )
+{
+	return os << t.str();
+}
+
+}  // namespace binding
+}  // namespace pywrap
+
+#endif  // PYWRAP_BINDING_TEXT_H_
@@ -26,13 +26,15 @@ class TypeObject : public Binding
 	void gen_sign() override;
 
 	/// @return A declaration of the bindings
-	void gen_decl() override;
+	void gen_decl( llvm::raw_ostream& decl ) const override;
 
 	/// @return A definition of the bindings
-	void gen_def() override;
+	void gen_def( llvm::raw_ostream& def ) const override;
 
   private:
-	const Tag& tag;
+	const Tag* tag;
+
+	friend class Tag;
 };
 }
 }
@@ -21,24 +21,29 @@ class Wrapper : public Binding
 	/// Generates the signature
 	void gen_sign() override;
 
-	/// Generates the declarations
-	void gen_decl() override;
+	/// Leaves the declarations to the printer
+	void gen_decl( llvm::raw_ostream& decl ) const override;
 
 	/// Generates Wrapper definitions
-	void gen_def() override;
+	void gen_def( llvm::raw_ostream& def ) const override;
 
   private:
 	/// Generates pointer constructor def
-	void gen_pointer_constructor_def();
+	/// @param[in] def Output stream
+	void gen_pointer_constructor_def( llvm::raw_ostream& def ) const;
 
 	/// Generates copy constructor def
-	void gen_copy_constructor_def();
+	/// @param[in] def Output stream
+	void gen_copy_constructor_def( llvm::raw_ostream& def ) const;
 
 	/// Generates move constructor def
-	void gen_move_constructor_def();
+	/// @param[in] def Output stream
+	void gen_move_constructor_def( llvm::raw_ostream& def ) const;
 
 	/// Wrapped Tag
 	const Tag* tag;
+
+	friend class Tag;
 };
 
 }  // namespace binding
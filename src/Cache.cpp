@@ -0,0 +1,151 @@
+#include "pywrap/Cache.h"
+
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+
+
+namespace pywrap
+{
+/// Changes whenever the layout of an entry or of the IR changes
+static const char cache_magic[] = "PYWRAPC4\n";
+
+
+std::string hash_file( const std::string& path )
+{
+	auto buffer = llvm::MemoryBuffer::getFile( path );
+	if ( !buffer )
+	{
+		return "";
+	}
+
+	llvm::MD5 hash;
+	hash.update( ( *buffer )->getBuffer() );
+	llvm::MD5::MD5Result result;
+	hash.final( result );
+	return result.digest().str();
+}
+
+
+Cache::Cache( std::string d, std::string o ) : dir{ std::move( d ) }, options{ std::move( o ) }
+{
+	llvm::sys::fs::create_directories( dir );
+}
+
+
+std::string Cache::get_path( const std::vector<clang::tooling::CompileCommand>& commands ) const
+{
+	llvm::MD5 hash;
+	hash.update( cache_magic );
+	hash.update( options );
+	hash.update( llvm::StringRef{ "\0", 1 } );
+	for ( auto& command : commands )
+	{
+		hash.update( command.Directory );
+		hash.update( llvm::StringRef{ "\0", 1 } );
+		for ( auto& arg : command.CommandLine )
+		{
+			hash.update( arg );
+			hash.update( llvm::StringRef{ "\0", 1 } );
+		}
+	}
+	llvm::MD5::MD5Result result;
+	hash.final( result );
+
+	llvm::SmallString<256> path{ dir };
+	llvm::sys::path::append( path, result.digest().str() + ".pwc" );
+	return path.str().str();
+}
+
+
+bool Cache::load( const std::vector<clang::tooling::CompileCommand>& commands, ir::Modules& modules,
+                  std::vector<std::string>& dependencies ) const
+{
+	auto buffer = llvm::MemoryBuffer::getFile( get_path( commands ) );
+	if ( !buffer )
+	{
+		return false;
+	}
+
+	auto data = ( *buffer )->getBuffer();
+	if ( !data.startswith( cache_magic ) )
+	{
+		return false;
+	}
+	data = data.drop_front( sizeof( cache_magic ) - 1 );
+
+	// Every dependency is stored on its own line, after the hash of its contents
+	std::vector<std::string> paths;
+	while ( true )
+	{
+		auto line = data.split( '\n' );
+		data      = line.second;
+		if ( line.first.empty() )
+		{
+			break;
+		}
+
+		auto digest = line.first.split( ' ' );
+		auto path   = digest.second.str();
+		if ( digest.second.empty() || hash_file( path ) != digest.first )
+		{
+			return false;
+		}
+		paths.emplace_back( std::move( path ) );
+	}
+
+	ir::Modules cached;
+	if ( !ir::read( data, cached ) )
+	{
+		return false;
+	}
+
+	modules      = std::move( cached );
+	dependencies = std::move( paths );
+	return true;
+}
+
+
+void Cache::store( const std::vector<clang::tooling::CompileCommand>& commands, const ir::Modules& modules,
+                   const std::vector<std::string>& dependencies, llvm::sys::TimePoint<> parse_start ) const
+{
+	// Modification times may only have a resolution of seconds, so a file modified within
+	// the second the parse started is considered modified after it
+	auto since = std::chrono::time_point_cast<std::chrono::seconds>( parse_start );
+	for ( auto& dependency : dependencies )
+	{
+		llvm::sys::fs::file_status status;
+		if ( llvm::sys::fs::status( dependency, status ) || status.getLastModificationTime() >= since )
+		{
+			return;
+		}
+	}
+
+	// Write to a temporary file first, so concurrent readers never see half an entry
+	int                    fd = 0;
+	llvm::SmallString<256> temp;
+	if ( llvm::sys::fs::createUniqueFile( dir + "/%%%%%%%%.tmp", fd, temp ) )
+	{
+		return;
+	}
+
+	{
+		llvm::raw_fd_ostream file{ fd, /* shouldClose = */ true };
+		file << cache_magic;
+		for ( auto& dependency : dependencies )
+		{
+			file << hash_file( dependency ) << ' ' << dependency << '\n';
+		}
+		file << '\n';
+		ir::write( file, modules );
+	}
+
+	if ( llvm::sys::fs::rename( temp, get_path( commands ) ) )
+	{
+		llvm::sys::fs::remove( temp );
+	}
+}
+
+
+}  // namespace pywrap
@@ -2,11 +2,41 @@
 
 namespace pywrap
 {
-Consumer::Consumer( std::unordered_map<std::string, binding::Module>& m, FrontendAction& frontend ) : handler{ m, frontend }
+namespace
 {
-	// Match classes with pyspot attribute
-	auto hasPyspot = clang::ast_matchers::hasAttr( clang::attr::Annotate );
-	auto pyMatcher = clang::ast_matchers::decl( hasPyspot ).bind( "PyspotTag" );
+/// Matches declarations with an annotate attribute of this value
+AST_MATCHER_P( clang::Decl, hasAnnotation, std::string, annotation )
+{
+	for ( auto attr : Node.specific_attrs<clang::AnnotateAttr>() )
+	{
+		if ( attr->getAnnotation() == annotation )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+/// Matches declarations within files accepted by the filter
+AST_MATCHER_P( clang::Decl, isExported, PathFilter*, filter )
+{
+	return filter->accepts( Finder->getASTContext().getSourceManager(), Node.getLocation() );
+}
+
+
+}  // namespace
+
+
+Consumer::Consumer( ir::Modules& m, const FrontendOptions& options, const Unit& unit,
+                    const std::vector<std::string>& includes )
+    : modules{ m }
+    , handler{ bindings, unit, includes }
+    , filter{ options.include_path_regex, options.exclude_path_regex }
+    , profile{ unit.profile }
+{
+	// Match classes with pyspot attribute, the cheaper check goes first
+	auto pyMatcher = clang::ast_matchers::decl( hasAnnotation( "pyspot" ), isExported( &filter ) ).bind( "PyspotTag" );
 	matcher.addMatcher( pyMatcher, &handler );
 }
 
@@ -14,7 +44,17 @@ Consumer::Consumer( std::unordered_map<std::string, binding::Module>& m, Fronten
 void Consumer::HandleTranslationUnit( clang::ASTContext& context )
 {
 	// Run the matchers when we have the whole TU parsed
-	matcher.matchAST( context );
+	{
+		ScopedTime time{ profile ? &profile->match : nullptr };
+		matcher.matchAST( context );
+	}
+
+	// Nothing referring to the AST outlives it, so it can be freed as soon as the action ends
+	{
+		ScopedTime time{ profile ? &profile->convert : nullptr };
+		ir::merge( modules, ir::from_bindings( bindings ) );
+		bindings.clear();
+	}
 }
 
 
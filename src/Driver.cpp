@@ -0,0 +1,498 @@
+#include "pywrap/Driver.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <thread>
+#include <unordered_set>
+
+#include <clang/Frontend/ASTUnit.h>
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/VirtualFileSystem.h>
+
+#include "pywrap/Consumer.h"
+
+
+namespace pywrap
+{
+Driver::Driver( const clang::tooling::CompilationDatabase& db, unsigned j ) : compilations{ db }, jobs{ j }
+{
+	if ( jobs == 0 )
+	{
+		jobs = std::max( std::thread::hardware_concurrency(), 1u );
+	}
+}
+
+
+bool Driver::write_ir( const std::string& source, const ir::Modules& result ) const
+{
+	// Sources with the same name in different directories get different files
+	llvm::MD5 hash;
+	hash.update( source );
+	llvm::MD5::MD5Result digest;
+	hash.final( digest );
+
+	llvm::SmallString<256> path{ ir_dir };
+	llvm::sys::path::append( path, llvm::sys::path::stem( source ) + "-" + digest.digest().substr( 0, 8 ) + ".pwir" );
+	if ( !ir::write_file( path.str().str(), result ) )
+	{
+		return false;
+	}
+
+	if ( ir_json )
+	{
+		llvm::sys::path::replace_extension( path, "json" );
+
+		std::error_code      error;
+		llvm::raw_fd_ostream file{ path, error, llvm::sys::fs::F_Text };
+		if ( error )
+		{
+			llvm::errs() << " while opening '" << path << "': " << error.message() << '\n';
+			return false;
+		}
+		ir::write_json( file, result );
+	}
+
+	return true;
+}
+
+
+int Driver::process( const std::string& source, const Unit& unit, ir::Modules& result,
+                     std::vector<std::string>& files )
+{
+	if ( unit.profile )
+	{
+		unit.profile->source = source;
+	}
+	ScopedTime time{ unit.profile ? &unit.profile->total : nullptr };
+
+	auto code = extract( source, unit, result, files );
+	if ( code == EXIT_SUCCESS && !ir_dir.empty() )
+	{
+		ScopedTime ir_time{ unit.profile ? &unit.profile->ir : nullptr };
+		if ( !write_ir( source, result ) )
+		{
+			code = EXIT_FAILURE;
+		}
+	}
+	return code;
+}
+
+
+int Driver::parse( const std::string& source, const Unit& unit, const FrontendOptions& opts, const bool use_pch,
+                   ir::Modules& result, std::vector<std::string>& dependencies ) const
+{
+	// A physical file system per translation unit, so its working directory does not affect other workers
+	clang::tooling::ClangTool tool{ compilations, { source }, std::make_shared<clang::PCHContainerOperations>(),
+		                            llvm::vfs::createPhysicalFileSystem().release() };
+	if ( use_pch && pch )
+	{
+		tool.appendArgumentsAdjuster( clang::tooling::getInsertArgumentAdjuster(
+		    { "-include-pch", pch->get_path() }, clang::tooling::ArgumentInsertPosition::BEGIN ) );
+	}
+
+	FrontendActionFactory factory{ opts, unit };
+	int                   code = EXIT_SUCCESS;
+	{
+		ScopedTime time{ unit.profile ? &unit.profile->frontend : nullptr };
+		code = tool.run( &factory );
+	}
+
+	// The consumer converted the bindings to IR before its AST was freed
+	result       = std::move( factory.get_modules() );
+	dependencies = factory.get_dependencies();
+	return code;
+}
+
+
+int Driver::load( const std::string& path, const Unit& unit, ir::Modules& result ) const
+{
+	ScopedTime time{ unit.profile ? &unit.profile->frontend : nullptr };
+
+	auto diagnostics = clang::CompilerInstance::createDiagnostics( new clang::DiagnosticOptions{} );
+	clang::PCHContainerOperations operations;
+	auto ast = clang::ASTUnit::LoadFromASTFile( path, operations.getRawReader(), clang::ASTUnit::LoadEverything,
+	                                            diagnostics, clang::FileSystemOptions{} );
+	if ( !ast )
+	{
+		llvm::errs() << "Could not load " << path << '\n';
+		return EXIT_FAILURE;
+	}
+
+	// Include directories are recorded within the AST file
+	std::vector<std::string> includes;
+	for ( auto& entry : ast->getHeaderSearchOpts().UserEntries )
+	{
+		includes.emplace_back( replace_all( entry.Path, "\\", "/" ) );
+	}
+
+	Consumer consumer{ result, options, unit, includes };
+	consumer.HandleTranslationUnit( ast->getASTContext() );
+	return EXIT_SUCCESS;
+}
+
+
+int Driver::extract( const std::string& source, const Unit& unit, ir::Modules& result,
+                     std::vector<std::string>& dependencies )
+{
+	// AST files are already parsed, so they are neither parsed nor cached
+	if ( llvm::sys::path::extension( source ) == ".ast" )
+	{
+		llvm::SmallString<256> path{ source };
+		llvm::sys::fs::make_absolute( path );
+		dependencies = { path.str().str() };
+		return load( source, unit, result );
+	}
+
+	auto commands = compilations.getCompileCommands( source );
+
+	if ( cache )
+	{
+		ScopedTime time{ unit.profile ? &unit.profile->ir : nullptr };
+		if ( cache->load( commands, result, dependencies ) )
+		{
+			if ( unit.profile )
+			{
+				unit.profile->cached = true;
+			}
+			return EXIT_SUCCESS;
+		}
+	}
+
+	auto                     parse_start = std::chrono::system_clock::now();
+	std::vector<std::string> files;
+	auto                     code = parse( source, unit, options, /* use_pch = */ true, result, files );
+	if ( code != EXIT_SUCCESS && ( options.skip_function_bodies || pch ) )
+	{
+		// Some code does not compile without bodies, or with a header built for other options, parse it again in full
+		llvm::errs() << "Parsing " << source << " again in full\n";
+		auto full                 = options;
+		full.skip_function_bodies = false;
+		code                      = parse( source, unit, full, /* use_pch = */ false, result, files );
+	}
+
+	if ( ( cache || incremental || track_dependencies ) && !commands.empty() )
+	{
+		// Files are relative to the directory of the compile command
+		dependencies.clear();
+		for ( auto& dependency : files )
+		{
+			llvm::SmallString<256> path{ dependency };
+			if ( llvm::sys::path::is_relative( path ) )
+			{
+				path = commands.front().Directory;
+				llvm::sys::path::append( path, dependency );
+			}
+			llvm::sys::path::remove_dots( path, /* remove_dot_dot = */ true );
+			dependencies.emplace_back( path.str().str() );
+		}
+		// Files loaded from the precompiled header are not read again by the frontend
+		if ( pch )
+		{
+			dependencies.insert( dependencies.end(), pch->get_dependencies().begin(), pch->get_dependencies().end() );
+		}
+	}
+
+	if ( cache && code == EXIT_SUCCESS && !commands.empty() )
+	{
+		ScopedTime time{ unit.profile ? &unit.profile->ir : nullptr };
+		cache->store( commands, result, dependencies, parse_start );
+	}
+
+	return code;
+}
+
+
+/// Collects the headers of the bindings of a module and of its nested modules
+/// @param[in] module Module to visit
+/// @param[out] includes Include paths of the headers
+static void collect_includes( const ir::Module& module, std::unordered_set<std::string>& includes )
+{
+	for ( auto& child : module.modules )
+	{
+		collect_includes( child, includes );
+	}
+
+	for ( auto bindings : { &module.functions, &module.enums, &module.templates, &module.specializations, &module.records } )
+	{
+		for ( auto& binding : *bindings )
+		{
+			includes.emplace( binding.incl );
+		}
+	}
+}
+
+
+/// @param[in] path Absolute path of a file
+/// @param[in] includes Include paths of the headers
+/// @return Whether the file is one of the headers, which are included relative to an include directory
+static bool is_included( const std::string& path, const std::unordered_set<std::string>& includes )
+{
+	auto file = replace_all( path, "\\", "/" );
+
+	for ( auto slash = file.find( '/' ); slash != std::string::npos; slash = file.find( '/', slash + 1 ) )
+	{
+		if ( includes.count( file.substr( slash + 1 ) ) )
+		{
+			return true;
+		}
+	}
+	return includes.count( file ) > 0;
+}
+
+
+std::vector<std::string> Driver::get_inputs( const bool all_headers ) const
+{
+	std::unordered_set<std::string> includes;
+	if ( !all_headers )
+	{
+		for ( auto& pr : modules )
+		{
+			collect_includes( pr.second, includes );
+		}
+	}
+
+	std::vector<std::string> inputs;
+	for ( auto& source : sources )
+	{
+		llvm::SmallString<256> path{ source };
+		llvm::sys::fs::make_absolute( path );
+		llvm::sys::path::remove_dots( path, /* remove_dot_dot = */ true );
+		inputs.emplace_back( path.str() );
+	}
+	for ( auto& files : dependencies )
+	{
+		for ( auto& file : files )
+		{
+			if ( all_headers || is_included( file, includes ) )
+			{
+				inputs.emplace_back( file );
+			}
+		}
+	}
+
+	std::sort( inputs.begin(), inputs.end() );
+	inputs.erase( std::unique( inputs.begin(), inputs.end() ), inputs.end() );
+	return inputs;
+}
+
+
+void Driver::build_pch( const std::string& source )
+{
+	auto commands = compilations.getCompileCommands( source );
+	pch.reset( new Pch{ pch_header, cache_dir.empty() ? "" : cache_dir + "/pch" } );
+	if ( commands.empty() || !pch->build( commands.front() ) )
+	{
+		llvm::errs() << "Could not precompile " << pch_header << ", parsing it within every translation unit\n";
+		pch.reset();
+	}
+}
+
+
+void Driver::extract_units( const std::vector<size_t>& indices )
+{
+	if ( report )
+	{
+		report->get_units().assign( sources.size(), UnitProfile{} );
+	}
+	auto start = Time::now();
+
+	std::atomic<size_t> next{ 0 };
+
+	auto work = [&]() {
+		for ( auto n = next++; n < indices.size(); n = next++ )
+		{
+			auto i    = indices[n];
+			auto unit = Unit{ i, extracted.get(), report ? &report->get_units()[i] : nullptr };
+			results[i].clear();
+			dependencies[i].clear();
+			codes[i] = process( sources[i], unit, results[i], dependencies[i] );
+		}
+	};
+
+	auto workers = std::min<size_t>( jobs, indices.size() );
+	if ( workers <= 1 )
+	{
+		work();
+	}
+	else
+	{
+		std::vector<std::thread> threads;
+		for ( size_t worker = 0; worker < workers; ++worker )
+		{
+			threads.emplace_back( work );
+		}
+		for ( auto& thread : threads )
+		{
+			thread.join();
+		}
+	}
+	stats.extracted_units = indices.size();
+
+	if ( report )
+	{
+		// Workers run on their own threads, so the CPU time is the sum of theirs
+		Time elapsed{ Time::now().wall - start.wall, 0.0 };
+		for ( auto& unit : report->get_units() )
+		{
+			elapsed.cpu += unit.total.cpu;
+		}
+		report->get_phase( "extract" ) += elapsed;
+	}
+	if ( memory_report )
+	{
+		memory_report->add_phase( "extract" );
+	}
+}
+
+
+void Driver::merge_units()
+{
+	modules.clear();
+
+	// Deterministic merge following the order of the sources, then sorted so the order does not matter
+	{
+		ScopedTime merge_time{ report ? &report->get_phase( "merge" ) : nullptr };
+		for ( auto& result : results )
+		{
+			if ( incremental )
+			{
+				// The results are kept for the next update
+				ir::merge( modules, ir::Modules{ result } );
+			}
+			else
+			{
+				ir::merge( modules, std::move( result ) );
+			}
+		}
+		ir::sort( modules );
+	}
+	if ( !incremental )
+	{
+		results.clear();
+	}
+
+	if ( memory_report )
+	{
+		memory_report->add_phase( "merge" );
+		memory_report->add_modules( modules );
+	}
+}
+
+
+int Driver::get_code() const
+{
+	auto code = std::max_element( codes.begin(), codes.end() );
+	return code == codes.end() ? EXIT_SUCCESS : *code;
+}
+
+
+int Driver::run( const std::vector<std::string>& srcs )
+{
+	sources = srcs;
+
+	// Entries extracted with different options do not mix
+	if ( !cache_dir.empty() )
+	{
+		cache.reset( new Cache{ cache_dir, options.get_key() } );
+	}
+
+	// Cache entries, IR files and updates need every binding of their translation unit
+	if ( cache_dir.empty() && ir_dir.empty() && !incremental )
+	{
+		extracted.reset( new Extracted{} );
+	}
+
+	if ( !ir_dir.empty() )
+	{
+		llvm::sys::fs::create_directories( ir_dir );
+	}
+
+	if ( !pch_header.empty() && !sources.empty() )
+	{
+		ScopedTime time{ report ? &report->get_phase( "pch" ) : nullptr };
+		build_pch( sources.front() );
+	}
+	if ( memory_report && pch )
+	{
+		memory_report->add_phase( "pch" );
+	}
+
+	results.assign( sources.size(), ir::Modules{} );
+	dependencies.assign( sources.size(), std::vector<std::string>{} );
+	codes.assign( sources.size(), EXIT_SUCCESS );
+
+	std::vector<size_t> indices( sources.size() );
+	std::iota( indices.begin(), indices.end(), 0 );
+	extract_units( indices );
+	merge_units();
+
+	if ( extracted )
+	{
+		stats.skipped_decls = extracted->get_skipped_decls();
+		extracted.reset();
+	}
+	if ( !incremental )
+	{
+		pch.reset();
+	}
+
+	return get_code();
+}
+
+
+int Driver::update( const std::vector<std::string>& files )
+{
+	if ( !incremental )
+	{
+		return run( std::vector<std::string>{ sources } );
+	}
+
+	std::unordered_set<std::string> changed{ files.begin(), files.end() };
+
+	auto affected = [&changed]( const std::vector<std::string>& paths ) {
+		for ( auto& path : paths )
+		{
+			if ( changed.count( path ) )
+			{
+				return true;
+			}
+		}
+		return false;
+	};
+
+	// A change to the precompiled prefix affects every translation unit
+	auto all = pch && affected( pch->get_dependencies() );
+	if ( all )
+	{
+		ScopedTime time{ report ? &report->get_phase( "pch" ) : nullptr };
+		build_pch( sources.front() );
+	}
+
+	std::vector<size_t> indices;
+	for ( size_t i = 0; i < sources.size(); ++i )
+	{
+		if ( all || affected( dependencies[i] ) )
+		{
+			indices.emplace_back( i );
+		}
+	}
+
+	stats.extracted_units = 0;
+	if ( indices.empty() )
+	{
+		return get_code();
+	}
+
+	extract_units( indices );
+	merge_units();
+	return get_code();
+}
+
+
+}  // namespace pywrap
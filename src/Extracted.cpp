@@ -0,0 +1,23 @@
+#include "pywrap/Extracted.h"
+
+
+namespace pywrap
+{
+bool Extracted::claim( const std::string& usr, const size_t unit )
+{
+	std::lock_guard<std::mutex> lock{ mutex };
+
+	auto pr = decls.emplace( usr, unit );
+	if ( pr.second || pr.first->second >= unit )
+	{
+		// A translation unit following in the order of the sources may have claimed it first, its binding is dropped
+		pr.first->second = unit;
+		return true;
+	}
+
+	++skipped_decls;
+	return false;
+}
+
+
+}  // namespace pywrap
@@ -2,6 +2,7 @@
 
 #include <clang/Frontend/CompilerInstance.h>
 #include <clang/Lex/HeaderSearch.h>
+#include <clang/Lex/PPCallbacks.h>
 
 #include "pywrap/Consumer.h"
 #include "pywrap/Util.h"
@@ -9,15 +10,86 @@
 
 namespace pywrap
 {
+namespace
+{
+/// Measures the time spent within every header, excluding the headers it includes.
+/// Parsing is interleaved with preprocessing, so that includes the time to parse it
+class HeaderTimer : public clang::PPCallbacks
+{
+  public:
+	HeaderTimer( const clang::SourceManager& s, UnitProfile& p ) : sources{ s }, profile{ p }, last{ Time::now() }
+	{
+	}
+
+	void FileChanged( clang::SourceLocation location, FileChangeReason reason, clang::SrcMgr::CharacteristicKind,
+	                  clang::FileID ) override
+	{
+		if ( reason != EnterFile && reason != ExitFile )
+		{
+			return;
+		}
+
+		// The location is within the file being entered or returned to
+		stop();
+		auto file  = sources.getFileID( location );
+		auto entry = sources.getFileEntryForID( file );
+		if ( entry && file != sources.getMainFileID() )
+		{
+			current = &profile.headers[get_path( *entry )];
+		}
+	}
+
+	void EndOfMainFile() override
+	{
+		stop();
+	}
+
+  private:
+	/// Adds the time elapsed since the last change to the current header
+	void stop()
+	{
+		auto now = Time::now();
+		if ( current )
+		{
+			*current += now - last;
+		}
+		current = nullptr;
+		last    = now;
+	}
+
+	const clang::SourceManager& sources;
+
+	UnitProfile& profile;
+
+	/// Time of the header being parsed, null within the main file
+	Time* current = nullptr;
+
+	Time last;
+};
+
+
+}  // namespace
+
+
 std::unique_ptr<clang::ASTConsumer> FrontendAction::CreateASTConsumer( clang::CompilerInstance& compiler,
                                                                        llvm::StringRef          file )
 {
-	return llvm::make_unique<Consumer>( modules, *this );
+	// Global includes are ready, as the action begins before creating its consumer
+	return llvm::make_unique<Consumer>( modules, options, unit, global_includes );
 }
 
 
 bool FrontendAction::BeginSourceFileAction( clang::CompilerInstance& compiler )
 {
+	// The parser still keeps the bodies it needs, like those with a deduced return type
+	compiler.getFrontendOpts().SkipFunctionBodies = options.skip_function_bodies;
+
+	if ( unit.profile )
+	{
+		compiler.getPreprocessor().addPPCallbacks(
+		    llvm::make_unique<HeaderTimer>( compiler.getSourceManager(), *unit.profile ) );
+	}
+
 	// Before executing the action get the global includes
 	auto& preprocessor = compiler.getPreprocessor();
 	auto& info         = preprocessor.getHeaderSearchInfo();
@@ -32,4 +104,16 @@ bool FrontendAction::BeginSourceFileAction( clang::CompilerInstance& compiler )
 }
 
 
+void FrontendAction::EndSourceFileAction()
+{
+	auto& sources = getCompilerInstance().getSourceManager();
+	for ( auto it = sources.fileinfo_begin(); it != sources.fileinfo_end(); ++it )
+	{
+		dependencies.push_back( it->first->getName().str() );
+	}
+
+	clang::ASTFrontendAction::EndSourceFileAction();
+}
+
+
 }  // namespace pywrap
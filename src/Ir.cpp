@@ -0,0 +1,768 @@
+#include "pywrap/Ir.h"
+
+#include <algorithm>
+
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/FormatVariadic.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include "pywrap/binding/Module.h"
+
+
+namespace pywrap
+{
+namespace ir
+{
+namespace
+{
+/// @param[in] items Vector of modules or bindings
+/// @param[in,out] index Positions of the items by id, rebuilt if it does not cover the vector
+/// @return The index of the items
+template <typename T>
+Index& get_index( const std::vector<T>& items, Index& index )
+{
+	if ( index.size() != items.size() )
+	{
+		index.clear();
+		for ( size_t i = 0; i < items.size(); ++i )
+		{
+			index.emplace( items[i].id, i );
+		}
+	}
+	return index;
+}
+
+
+/// Adds the helpers called by a binding to a module, unless already there
+/// @param[in] module Module of the binding
+/// @param[in] binding Binding calling the helpers
+void add_converters( Module& module, const binding::Binding& binding )
+{
+	auto& index = get_index( module.converters, module.indexes.converters );
+	for ( auto& converter : binding.get_converters().get_converters() )
+	{
+		if ( index.emplace( converter.name, module.converters.size() ).second )
+		{
+			Binding ret;
+			ret.kind = Kind::Converter;
+			ret.id   = converter.name;
+			ret.name = converter.type;
+			ret.decl = converter.decl;
+			ret.def  = converter.def;
+			module.converters.emplace_back( std::move( ret ) );
+		}
+	}
+}
+
+
+/// Adds the helpers called by the initializer and the accessors of a record to a module
+/// @param[in] module Module of the record
+/// @param[in] record Record calling the helpers
+void add_converters( Module& module, const binding::CXXRecord& record )
+{
+	add_converters( module, record.get_init() );
+	for ( auto& field : record.get_fields() )
+	{
+		add_converters( module, field.get_getter() );
+		add_converters( module, field.get_setter() );
+	}
+}
+
+
+Binding from_tag( Kind kind, const binding::Tag& tag )
+{
+	Binding ret;
+	ret.kind           = kind;
+	ret.id             = tag.get_id();
+	ret.name           = tag.get_name();
+	ret.qualified_name = tag.get_qualified_name();
+	ret.py_name        = tag.get_py_name();
+	ret.incl           = tag.get_incl();
+
+	// Fields are stored on their own, parts are printed straight into the IR
+	llvm::raw_string_ostream decl{ ret.decl };
+	tag.binding::Tag::print_decl( decl );
+	decl.flush();
+
+	llvm::raw_string_ostream def{ ret.def };
+	if ( kind == Kind::Template )
+	{
+		// Cases are stored on their own, so the ones of other translation units can be merged
+		tag.print_open_def( def );
+		for ( auto& item : tag.get_class_getitem().get_items() )
+		{
+			Binding case_item;
+			case_item.kind = Kind::Specialization;
+			case_item.id   = item.id;
+
+			llvm::raw_string_ostream case_def{ case_item.def };
+			binding::ClassGetitem::print_item( case_def, item );
+			case_def.flush();
+
+			ret.items.emplace_back( std::move( case_item ) );
+		}
+	}
+	else
+	{
+		tag.binding::Tag::print_def( def );
+	}
+	def.flush();
+
+	return ret;
+}
+
+
+Binding from_record( Kind kind, const binding::CXXRecord& record )
+{
+	auto ret = from_tag( kind, record );
+
+	for ( auto& field : record.get_fields() )
+	{
+		Binding accessors;
+		accessors.kind           = Kind::Field;
+		accessors.id             = record.get_qualified_name() + "::" + field.get_name();
+		accessors.name           = field.get_name();
+		accessors.qualified_name = accessors.id;
+		accessors.type           = field.get_type().getAsString();
+
+		llvm::raw_string_ostream decl{ accessors.decl };
+		field.get_getter().print_decl( decl );
+		field.get_setter().print_decl( decl );
+		decl.flush();
+
+		llvm::raw_string_ostream def{ accessors.def };
+		field.get_getter().print_def( def );
+		field.get_setter().print_def( def );
+		def.flush();
+
+		ret.fields.emplace_back( std::move( accessors ) );
+	}
+
+	return ret;
+}
+
+
+Binding from_enum( const binding::Enum& enu )
+{
+	auto ret = from_tag( Kind::Enum, enu );
+	for ( auto constant : enu.get_enum().enumerators() )
+	{
+		ret.constants.emplace_back( constant->getNameAsString() );
+	}
+	return ret;
+}
+
+
+Binding from_specialization( const binding::Specialization& spec )
+{
+	auto ret = from_record( Kind::Specialization, spec );
+	// Specializations share the id of their template
+	ret.id = spec.get_qualified_name();
+	for ( auto& arg : spec.get_args() )
+	{
+		ret.args.emplace_back( arg.getAsType().getAsString() );
+	}
+	return ret;
+}
+
+
+Binding from_function( const binding::Function& function )
+{
+	auto& func = function.get_func();
+
+	Binding ret;
+	ret.kind           = Kind::Function;
+	ret.id             = function.get_id();
+	ret.name           = function.get_name();
+	ret.qualified_name = function.get_qualified_name();
+	ret.py_name        = function.get_py_name();
+	ret.type           = func.getReturnType().getAsString();
+	ret.incl           = function.get_incl();
+	ret.decl           = function.get_decl();
+	ret.def            = function.get_def();
+	for ( auto param : func.parameters() )
+	{
+		ret.params.emplace_back( param->getType().getAsString() );
+	}
+	return ret;
+}
+
+
+Module from_module( const binding::Module& module )
+{
+	Module ret;
+	ret.id      = module.get_id();
+	ret.name    = module.get_name();
+	ret.py_name = module.get_py_name();
+	ret.nested  = module.is_nested();
+	ret.decl    = module.get_decl();
+	ret.def     = module.get_def();
+	ret.methods = module.get_methods().get_def();
+
+	for ( auto& child : module.get_modules() )
+	{
+		ret.modules.emplace_back( from_module( child ) );
+	}
+
+	for ( auto& function : module.get_functions() )
+	{
+		ret.functions.emplace_back( from_function( function ) );
+		add_converters( ret, function );
+	}
+
+	for ( auto& enu : module.get_enums() )
+	{
+		ret.enums.emplace_back( from_enum( enu ) );
+		add_converters( ret, enu.get_init() );
+	}
+
+	for ( auto& templ : module.get_templates() )
+	{
+		ret.templates.emplace_back( from_tag( Kind::Template, templ ) );
+		add_converters( ret, templ.get_init() );
+	}
+
+	for ( auto& spec : module.get_specializations() )
+	{
+		ret.specializations.emplace_back( from_specialization( spec ) );
+		add_converters( ret, spec );
+	}
+
+	for ( auto& record : module.get_records() )
+	{
+		ret.records.emplace_back( from_record( Kind::Record, record ) );
+		add_converters( ret, record );
+	}
+
+	return ret;
+}
+
+
+/// Adds the cases of the __class_getitem__ of a template which are not already there
+/// @param[in] into Cases to merge into
+/// @param[in] from Cases to merge
+void merge_items( std::vector<Binding>& into, std::vector<Binding>&& from )
+{
+	Index index;
+	get_index( into, index );
+	for ( auto& item : from )
+	{
+		if ( index.emplace( item.id, into.size() ).second )
+		{
+			into.emplace_back( std::move( item ) );
+		}
+	}
+}
+
+
+/// Adds the bindings which are not already there, looking them up by id
+/// @param[in] into Bindings to merge into
+/// @param[in] index Positions of the bindings to merge into
+/// @param[in] from Bindings to merge
+void merge_bindings( std::vector<Binding>& into, Index& index, std::vector<Binding>&& from )
+{
+	get_index( into, index );
+	for ( auto& binding : from )
+	{
+		auto pr = index.emplace( binding.id, into.size() );
+		if ( pr.second )
+		{
+			into.emplace_back( std::move( binding ) );
+		}
+		else
+		{
+			// A template keeps its first definition, with the specializations of every translation unit
+			merge_items( into[pr.first->second].items, std::move( binding.items ) );
+		}
+	}
+}
+
+
+void merge_module( Module& into, Module&& from )
+{
+	auto& index = get_index( into.modules, into.indexes.modules );
+	for ( auto& child : from.modules )
+	{
+		auto pr = index.emplace( child.id, into.modules.size() );
+		if ( pr.second )
+		{
+			into.modules.emplace_back( std::move( child ) );
+		}
+		else
+		{
+			merge_module( into.modules[pr.first->second], std::move( child ) );
+		}
+	}
+
+	auto& indexes = into.indexes;
+	merge_bindings( into.functions, indexes.functions, std::move( from.functions ) );
+	merge_bindings( into.enums, indexes.enums, std::move( from.enums ) );
+	merge_bindings( into.templates, indexes.templates, std::move( from.templates ) );
+	merge_bindings( into.specializations, indexes.specializations, std::move( from.specializations ) );
+	merge_bindings( into.records, indexes.records, std::move( from.records ) );
+	merge_bindings( into.converters, indexes.converters, std::move( from.converters ) );
+}
+
+
+template <typename T>
+void sort_by_id( std::vector<T>& items )
+{
+	std::sort( std::begin( items ), std::end( items ), []( const T& a, const T& b ) { return a.id < b.id; } );
+}
+
+
+void sort_module( Module& module )
+{
+	for ( auto& child : module.modules )
+	{
+		sort_module( child );
+	}
+
+	// Fields keep the order of their declarations
+	sort_by_id( module.modules );
+	sort_by_id( module.functions );
+	sort_by_id( module.enums );
+	sort_by_id( module.templates );
+	for ( auto& templ : module.templates )
+	{
+		sort_by_id( templ.items );
+	}
+	sort_by_id( module.specializations );
+	sort_by_id( module.records );
+	sort_by_id( module.converters );
+
+	// Positions changed, the indexes are rebuilt by the next merge
+	module.indexes = {};
+}
+
+
+void write_value( llvm::raw_ostream& os, uint32_t value )
+{
+	char bytes[] = { static_cast<char>( value & 0xff ), static_cast<char>( ( value >> 8 ) & 0xff ),
+		             static_cast<char>( ( value >> 16 ) & 0xff ), static_cast<char>( ( value >> 24 ) & 0xff ) };
+	os.write( bytes, sizeof( bytes ) );
+}
+
+
+void write_value( llvm::raw_ostream& os, const std::string& str )
+{
+	write_value( os, static_cast<uint32_t>( str.size() ) );
+	os << str;
+}
+
+
+void write_value( llvm::raw_ostream& os, const std::vector<std::string>& strs )
+{
+	write_value( os, static_cast<uint32_t>( strs.size() ) );
+	for ( auto& str : strs )
+	{
+		write_value( os, str );
+	}
+}
+
+
+void write_value( llvm::raw_ostream& os, const Binding& binding );
+
+
+void write_value( llvm::raw_ostream& os, const std::vector<Binding>& bindings )
+{
+	write_value( os, static_cast<uint32_t>( bindings.size() ) );
+	for ( auto& binding : bindings )
+	{
+		write_value( os, binding );
+	}
+}
+
+
+void write_value( llvm::raw_ostream& os, const Binding& binding )
+{
+	write_value( os, static_cast<uint32_t>( binding.kind ) );
+	write_value( os, binding.id );
+	write_value( os, binding.name );
+	write_value( os, binding.qualified_name );
+	write_value( os, binding.py_name );
+	write_value( os, binding.type );
+	write_value( os, binding.params );
+	write_value( os, binding.constants );
+	write_value( os, binding.args );
+	write_value( os, binding.incl );
+	write_value( os, binding.decl );
+	write_value( os, binding.def );
+	write_value( os, binding.fields );
+	write_value( os, binding.items );
+}
+
+
+void write_value( llvm::raw_ostream& os, const Module& module )
+{
+	write_value( os, module.id );
+	write_value( os, module.name );
+	write_value( os, module.py_name );
+	write_value( os, static_cast<uint32_t>( module.nested ) );
+	write_value( os, module.decl );
+	write_value( os, module.def );
+	write_value( os, module.methods );
+
+	write_value( os, static_cast<uint32_t>( module.modules.size() ) );
+	for ( auto& child : module.modules )
+	{
+		write_value( os, child );
+	}
+
+	write_value( os, module.functions );
+	write_value( os, module.enums );
+	write_value( os, module.templates );
+	write_value( os, module.specializations );
+	write_value( os, module.records );
+	write_value( os, module.converters );
+}
+
+
+bool read_value( llvm::StringRef& data, uint32_t& value )
+{
+	if ( data.size() < 4 )
+	{
+		return false;
+	}
+
+	auto bytes = data.bytes_begin();
+	value      = bytes[0] | ( bytes[1] << 8 ) | ( bytes[2] << 16 ) | ( static_cast<uint32_t>( bytes[3] ) << 24 );
+	data       = data.drop_front( 4 );
+	return true;
+}
+
+
+bool read_value( llvm::StringRef& data, std::string& str )
+{
+	uint32_t size = 0;
+	if ( !read_value( data, size ) || data.size() < size )
+	{
+		return false;
+	}
+
+	str  = data.take_front( size ).str();
+	data = data.drop_front( size );
+	return true;
+}
+
+
+bool read_value( llvm::StringRef& data, std::vector<std::string>& strs )
+{
+	// Every string takes at least its size
+	uint32_t count = 0;
+	if ( !read_value( data, count ) || count > data.size() )
+	{
+		return false;
+	}
+
+	strs.resize( count );
+	for ( auto& str : strs )
+	{
+		if ( !read_value( data, str ) )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool read_value( llvm::StringRef& data, Binding& binding );
+
+
+bool read_value( llvm::StringRef& data, std::vector<Binding>& bindings )
+{
+	// Every binding takes more than a byte
+	uint32_t count = 0;
+	if ( !read_value( data, count ) || count > data.size() )
+	{
+		return false;
+	}
+
+	bindings.resize( count );
+	for ( auto& binding : bindings )
+	{
+		if ( !read_value( data, binding ) )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool read_value( llvm::StringRef& data, Binding& binding )
+{
+	uint32_t kind = 0;
+	if ( !read_value( data, kind ) || kind > static_cast<uint32_t>( Kind::Converter ) )
+	{
+		return false;
+	}
+	binding.kind = static_cast<Kind>( kind );
+
+	return read_value( data, binding.id ) && read_value( data, binding.name ) &&
+	       read_value( data, binding.qualified_name ) && read_value( data, binding.py_name ) &&
+	       read_value( data, binding.type ) && read_value( data, binding.params ) &&
+	       read_value( data, binding.constants ) && read_value( data, binding.args ) &&
+	       read_value( data, binding.incl ) && read_value( data, binding.decl ) && read_value( data, binding.def ) &&
+	       read_value( data, binding.fields ) && read_value( data, binding.items );
+}
+
+
+bool read_value( llvm::StringRef& data, Module& module )
+{
+	uint32_t nested = 0;
+	if ( !read_value( data, module.id ) || !read_value( data, module.name ) || !read_value( data, module.py_name ) ||
+	     !read_value( data, nested ) || !read_value( data, module.decl ) || !read_value( data, module.def ) ||
+	     !read_value( data, module.methods ) )
+	{
+		return false;
+	}
+	module.nested = nested != 0;
+
+	uint32_t count = 0;
+	if ( !read_value( data, count ) || count > data.size() )
+	{
+		return false;
+	}
+
+	module.modules.resize( count );
+	for ( auto& child : module.modules )
+	{
+		if ( !read_value( data, child ) )
+		{
+			return false;
+		}
+	}
+
+	return read_value( data, module.functions ) && read_value( data, module.enums ) &&
+	       read_value( data, module.templates ) && read_value( data, module.specializations ) &&
+	       read_value( data, module.records ) && read_value( data, module.converters );
+}
+
+
+llvm::json::Value to_json( const Binding& binding );
+
+
+llvm::json::Value to_json( const std::vector<Binding>& bindings )
+{
+	llvm::json::Array ret;
+	for ( auto& binding : bindings )
+	{
+		ret.push_back( to_json( binding ) );
+	}
+	return std::move( ret );
+}
+
+
+llvm::json::Value to_json( const Binding& binding )
+{
+	return llvm::json::Object{ { "kind", to_string( binding.kind ) },
+		                       { "id", binding.id },
+		                       { "name", binding.name },
+		                       { "qualified_name", binding.qualified_name },
+		                       { "py_name", binding.py_name },
+		                       { "type", binding.type },
+		                       { "params", binding.params },
+		                       { "constants", binding.constants },
+		                       { "args", binding.args },
+		                       { "incl", binding.incl },
+		                       { "decl", binding.decl },
+		                       { "def", binding.def },
+		                       { "fields", to_json( binding.fields ) },
+		                       { "items", to_json( binding.items ) } };
+}
+
+
+llvm::json::Value to_json( const Module& module )
+{
+	llvm::json::Array children;
+	for ( auto& child : module.modules )
+	{
+		children.push_back( to_json( child ) );
+	}
+
+	return llvm::json::Object{ { "id", module.id },
+		                       { "name", module.name },
+		                       { "py_name", module.py_name },
+		                       { "nested", module.nested },
+		                       { "decl", module.decl },
+		                       { "def", module.def },
+		                       { "methods", module.methods },
+		                       { "modules", std::move( children ) },
+		                       { "functions", to_json( module.functions ) },
+		                       { "enums", to_json( module.enums ) },
+		                       { "templates", to_json( module.templates ) },
+		                       { "specializations", to_json( module.specializations ) },
+		                       { "records", to_json( module.records ) },
+		                       { "converters", to_json( module.converters ) } };
+}
+
+
+/// Changes whenever the layout of the IR changes
+const char file_magic[] = "PYWRAPI4\n";
+
+
+}  // namespace
+
+
+const char* to_string( Kind kind )
+{
+	switch ( kind )
+	{
+		case Kind::Function:
+			return "function";
+		case Kind::Enum:
+			return "enum";
+		case Kind::Template:
+			return "template";
+		case Kind::Specialization:
+			return "specialization";
+		case Kind::Record:
+			return "record";
+		case Kind::Field:
+			return "field";
+		case Kind::Converter:
+			return "converter";
+	}
+	return "";
+}
+
+
+Modules from_bindings( const std::unordered_map<std::string, binding::Module>& modules )
+{
+	Modules ret;
+	for ( auto& pr : modules )
+	{
+		ret.emplace( pr.first, from_module( pr.second ) );
+	}
+	return ret;
+}
+
+
+void merge( Modules& into, Modules&& from )
+{
+	for ( auto& pr : from )
+	{
+		auto it = into.find( pr.first );
+		if ( it == into.end() )
+		{
+			into.emplace( pr.first, std::move( pr.second ) );
+		}
+		else
+		{
+			merge_module( it->second, std::move( pr.second ) );
+		}
+	}
+}
+
+
+void sort( Modules& modules )
+{
+	for ( auto& pr : modules )
+	{
+		sort_module( pr.second );
+	}
+}
+
+
+void write( llvm::raw_ostream& os, const Modules& modules )
+{
+	write_value( os, static_cast<uint32_t>( modules.size() ) );
+	for ( auto& pr : modules )
+	{
+		write_value( os, pr.first );
+		write_value( os, pr.second );
+	}
+}
+
+
+bool read( llvm::StringRef& data, Modules& modules )
+{
+	uint32_t count = 0;
+	if ( !read_value( data, count ) )
+	{
+		return false;
+	}
+
+	for ( uint32_t i = 0; i < count; ++i )
+	{
+		std::string id;
+		Module      module;
+		if ( !read_value( data, id ) || !read_value( data, module ) )
+		{
+			return false;
+		}
+
+		auto it = modules.find( id );
+		if ( it == modules.end() )
+		{
+			modules.emplace( std::move( id ), std::move( module ) );
+		}
+		else
+		{
+			merge_module( it->second, std::move( module ) );
+		}
+	}
+
+	return true;
+}
+
+
+void write_json( llvm::raw_ostream& os, const Modules& modules )
+{
+	llvm::json::Object root;
+	for ( auto& pr : modules )
+	{
+		root[pr.first] = to_json( pr.second );
+	}
+	os << llvm::formatv( "{0:2}", llvm::json::Value{ std::move( root ) } ) << '\n';
+}
+
+
+bool write_file( const std::string& path, const Modules& modules )
+{
+	std::error_code      error;
+	llvm::raw_fd_ostream file{ path, error, llvm::sys::fs::F_None };
+	if ( error )
+	{
+		llvm::errs() << " while opening '" << path << "': " << error.message() << '\n';
+		return false;
+	}
+
+	file << file_magic;
+	write( file, modules );
+	return true;
+}
+
+
+bool read_file( const std::string& path, Modules& modules )
+{
+	auto buffer = llvm::MemoryBuffer::getFile( path );
+	if ( !buffer )
+	{
+		llvm::errs() << " while opening '" << path << "': " << buffer.getError().message() << '\n';
+		return false;
+	}
+
+	auto data  = ( *buffer )->getBuffer();
+	auto valid = data.startswith( file_magic );
+	if ( valid )
+	{
+		data  = data.drop_front( sizeof( file_magic ) - 1 );
+		valid = read( data, modules );
+	}
+
+	if ( !valid )
+	{
+		llvm::errs() << " while reading '" << path << "': not a valid IR file\n";
+		return false;
+	}
+
+	return true;
+}
+
+
+}  // namespace ir
+}  // namespace pywrap
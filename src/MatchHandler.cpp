@@ -3,6 +3,8 @@
 #include <algorithm>
 #include <sstream>
 
+#include <clang/Index/USRGeneration.h>
+
 #include "pywrap/binding/CXXRecord.h"
 #include "pywrap/binding/Enum.h"
 #include "pywrap/binding/Function.h"
@@ -17,37 +19,51 @@ std::string get_cwd()
 	return pywrap::replace_all( cwd.str().str(), "\\", "/" );
 }
 
-MatchHandler::MatchHandler( std::unordered_map<std::string, binding::Module>& m, FrontendAction& f )
-    : modules{ m }, frontend{ f }
+MatchHandler::MatchHandler( std::unordered_map<std::string, binding::Module>& m, const Unit& u,
+                            const std::vector<std::string>& i )
+    : modules{ m }, unit{ u }, global_includes{ i }
 {
 }
 
-std::string MatchHandler::get_include_path( const clang::Decl& decl )
+const std::string& MatchHandler::get_include_path( const clang::Decl& decl )
 {
-	auto location = decl.getLocation().printToString( context->getSourceManager() );
-	pywrap::replace_all( location, "\\", "/" );
+	auto& sources = context->getSourceManager();
+	auto  file    = sources.getFileID( sources.getExpansionLoc( decl.getLocation() ) );
 
-	// Remove include directories from path
-	for ( auto& path : frontend.get_global_includes() )
+	// Every decl within a file shares the same include path
+	auto it = include_paths.find( file );
+	if ( it != include_paths.end() )
 	{
-		auto found = location.find( path );
+		return it->second;
+	}
 
-		if ( found == 0 )
+	// Include directories are known once the preprocessor is set up
+	if ( include_dirs.empty() )
+	{
+		for ( auto& dir : global_includes )
 		{
-			auto cwdLen = path.size() + 1;  // remove '/' as well
-			location    = location.substr( cwdLen, location.length() - cwdLen );
-			break;
+			include_dirs.emplace( llvm::StringRef{ dir }.rtrim( '/' ).str() );
 		}
 	}
 
-	// Remove everything after ":"
-	auto found = location.find( ":" );
-	if ( found != std::string::npos )
+	std::string path;
+	if ( auto entry = sources.getFileEntryForID( file ) )
+	{
+		path = replace_all( entry->getName().str(), "\\", "/" );
+	}
+
+	// Remove the longest include directory containing the file, walking up its parents
+	llvm::StringRef include{ path };
+	for ( auto slash = include.rfind( '/' ); slash != llvm::StringRef::npos; slash = include.rfind( '/', slash ) )
 	{
-		location = location.substr( 0, found );
+		if ( include_dirs.count( include.substr( 0, slash ).str() ) )
+		{
+			include = include.drop_front( slash + 1 );
+			break;
+		}
 	}
 
-	return location;
+	return include_paths[file] = include.str();
 }
 
 
@@ -63,17 +79,13 @@ binding::Module& MatchHandler::get_module( const clang::DeclContext& ctx )
 	{
 		auto& parent = get_module( *named_context );
 		// Find the module within the children of the parent
-		auto& children = parent.get_children();
-		auto  it       = std::find_if( std::begin( children ), std::end( children ),
-                                [id]( binding::Module& child ) { return child.get_id() == id; } );
-		if ( it == std::end( children ) )
+		if ( auto child = parent.find_child( id ) )
 		{
-			// Create if not found
-			parent.add( binding::Module{ *named_decl, &parent } );
-			return children.back();
+			return *child;
 		}
-		// Return the module
-		return *it;
+		// Create if not found
+		parent.add( binding::Module{ *named_decl, &parent } );
+		return parent.get_children().back();
 	}
 
 	// Find it between the root modules
@@ -90,9 +102,32 @@ binding::Module& MatchHandler::get_module( const clang::DeclContext& ctx )
 	return it->second;
 }
 
+bool MatchHandler::claim( const clang::Decl& decl )
+{
+	auto extracted = unit.extracted;
+	if ( !extracted )
+	{
+		return true;
+	}
+
+	llvm::SmallString<128> usr;
+	if ( clang::index::generateUSRForDecl( &decl, usr ) )
+	{
+		// No USR, keep it
+		return true;
+	}
+	return extracted->claim( usr.str().str(), unit.index );
+}
+
+
 template <typename B, typename D>
 B MatchHandler::create_binding( const D& decl, const binding::Binding& parent )
 {
+	if ( auto profile = unit.profile )
+	{
+		++profile->generated_bindings;
+	}
+
 	B binding{ decl, parent };
 	binding.set_incl( get_include_path( decl ) );
 	return binding;
@@ -146,41 +181,49 @@ void MatchHandler::generate_bindings( const clang::Decl& decl )
 	// Generate function bindings
 	if ( auto func_decl = clang::dyn_cast<clang::FunctionDecl>( &decl ) )
 	{
-		auto it = find_if( std::begin( module.get_functions() ), std::end( module.get_functions() ),
-		                   [func_decl]( const binding::Function& func ) {
-			                   return func.get_id() == func_decl->getQualifiedNameAsString();
-		                   } );
-		if ( it == std::end( module.get_functions() ) )
+		auto id = func_decl->getQualifiedNameAsString();
+		if ( !module.has_function( id ) && !skipped_functions.count( id ) )
 		{
-			// Add the function to the module
-			module.add( create_binding<binding::Function>( *func_decl, module ) );
+			if ( claim( *func_decl ) )
+			{
+				// Add the function to the module
+				module.add( create_binding<binding::Function>( *func_decl, module ) );
+			}
+			else
+			{
+				skipped_functions.emplace( std::move( id ) );
+			}
 		}
 	}
 	// Generate enum bindings
 	else if ( auto enum_decl = clang::dyn_cast<clang::EnumDecl>( &decl ) )
 	{
-		auto it = find_if(
-		    std::begin( module.get_enums() ), std::end( module.get_enums() ),
-		    [enum_decl]( const binding::Enum& enu ) { return enu.get_id() == enum_decl->getQualifiedNameAsString(); } );
-		if ( it == std::end( module.get_enums() ) )
+		auto id = enum_decl->getQualifiedNameAsString();
+		if ( !module.has_enum( id ) && !skipped_enums.count( id ) )
 		{
-			// Add the enum to the module
-			module.add( create_binding<binding::Enum>( *enum_decl, module ) );
+			if ( claim( *enum_decl ) )
+			{
+				// Add the enum to the module
+				module.add( create_binding<binding::Enum>( *enum_decl, module ) );
+			}
+			else
+			{
+				skipped_enums.emplace( std::move( id ) );
+			}
 		}
 	}
 	// Generate struct/union/class bindings
 	else if ( auto record_decl = clang::dyn_cast<clang::CXXRecordDecl>( &decl ) )
 	{
-		auto it = find_if( std::begin( module.get_records() ), std::end( module.get_records() ),
-		                   [record_decl]( const binding::CXXRecord& record ) {
-			                   return record.get_id() == record_decl->getQualifiedNameAsString();
-		                   } );
-		if ( it == std::end( module.get_records() ) )
+		auto id = record_decl->getQualifiedNameAsString();
+		if ( !module.has_record( id ) && !skipped_records.count( id ) )
 		{
 			// It it is a template
 			if ( record_decl->isTemplated() )
 			{
 				auto template_decl = record_decl->getDescribedClassTemplate();
+
+				// Specializations depend on the translation unit, so templates are never claimed
 				auto templ         = create_binding<binding::Template>( *template_decl, module );
 				templ.init();
 
@@ -197,6 +240,10 @@ void MatchHandler::generate_bindings( const clang::Decl& decl )
 
 				module.add( std::move( templ ) );
 			}
+			else if ( !claim( *record_decl ) )
+			{
+				skipped_records.emplace( std::move( id ) );
+			}
 			else
 			{
 				// Add the record to the module
@@ -221,16 +268,17 @@ void MatchHandler::run( const clang::ast_matchers::MatchFinder::MatchResult& res
 	// Save current context
 	context = result.Context;
 
+	// The matcher already checked the pyspot annotation
 	if ( auto decl = result.Nodes.getNodeAs<clang::Decl>( "PyspotTag" ) )
 	{
-		if ( auto annotate = decl->getAttr<clang::AnnotateAttr>() )
+		auto profile = unit.profile;
+		if ( profile )
 		{
-			if ( annotate->getAnnotation() == "pyspot" )
-			{
-				// Generate bindings for a decl with pyspot annotation
-				generate_bindings( *decl );
-			}
+			++profile->matched_decls;
 		}
+
+		ScopedTime time{ profile ? &profile->bindings : nullptr };
+		generate_bindings( *decl );
 	}
 }
 
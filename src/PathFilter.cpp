@@ -0,0 +1,47 @@
+#include "pywrap/PathFilter.h"
+
+#include "pywrap/Util.h"
+
+
+namespace pywrap
+{
+PathFilter::PathFilter( const std::string& i, const std::string& e )
+    : include{ i }, exclude{ e }, has_include{ !i.empty() }, has_exclude{ !e.empty() }
+{
+}
+
+
+bool PathFilter::accepts( const clang::SourceManager& sources, const clang::SourceLocation location )
+{
+	// Declarations expanded from a macro belong to the file where the macro is used
+	auto file = sources.getFileID( sources.getExpansionLoc( location ) );
+
+	auto it = results.find( file );
+	if ( it == results.end() )
+	{
+		it = results.insert( { file, accepts_file( sources, file ) } ).first;
+	}
+	return it->second;
+}
+
+
+bool PathFilter::accepts_file( const clang::SourceManager& sources, const clang::FileID file )
+{
+	// Builtins and command line macros have no file
+	auto entry = file.isValid() ? sources.getFileEntryForID( file ) : nullptr;
+	if ( !entry )
+	{
+		return !has_include;
+	}
+
+	if ( sources.isInSystemHeader( sources.getLocForStartOfFile( file ) ) )
+	{
+		return false;
+	}
+
+	auto path = get_path( *entry );
+	return ( !has_include || include.match( path ) ) && ( !has_exclude || !exclude.match( path ) );
+}
+
+
+}  // namespace pywrap
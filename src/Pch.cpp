@@ -0,0 +1,251 @@
+#include "pywrap/Pch.h"
+
+#include <algorithm>
+
+#include <clang/Basic/FileManager.h>
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/FrontendActions.h>
+#include <clang/Tooling/ArgumentsAdjusters.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/VirtualFileSystem.h>
+
+#include "pywrap/Cache.h"
+
+
+namespace pywrap
+{
+/// Changes whenever the layout of the dependencies file changes
+static const char pch_magic[] = "PYWRAPP1\n";
+
+
+namespace
+{
+/// Generates a precompiled header, collecting the files it reads
+class PchAction : public clang::GeneratePCHAction
+{
+  public:
+	PchAction( std::vector<std::string>& d ) : dependencies{ d }
+	{
+	}
+
+	void EndSourceFileAction() override
+	{
+		auto& sources = getCompilerInstance().getSourceManager();
+		for ( auto it = sources.fileinfo_begin(); it != sources.fileinfo_end(); ++it )
+		{
+			dependencies.push_back( it->first->getName().str() );
+		}
+
+		clang::GeneratePCHAction::EndSourceFileAction();
+	}
+
+  private:
+	std::vector<std::string>& dependencies;
+};
+
+
+class PchActionFactory : public clang::tooling::FrontendActionFactory
+{
+  public:
+	clang::FrontendAction* create() override
+	{
+		return new PchAction{ dependencies };
+	}
+
+	/// @return The files read by the action, relative to the working directory of the compile command
+	const std::vector<std::string>& get_dependencies() const
+	{
+		return dependencies;
+	}
+
+  private:
+	std::vector<std::string> dependencies;
+};
+
+
+}  // namespace
+
+
+Pch::Pch( std::string h, std::string d ) : header{ std::move( h ) }, dir{ std::move( d ) }
+{
+	llvm::SmallString<256> absolute{ header };
+	llvm::sys::fs::make_absolute( absolute );
+	header = absolute.str().str();
+
+	if ( !dir.empty() )
+	{
+		llvm::sys::fs::create_directories( dir );
+	}
+}
+
+
+Pch::~Pch()
+{
+	if ( dir.empty() && !path.empty() )
+	{
+		llvm::sys::fs::remove( path );
+	}
+}
+
+
+std::vector<std::string> Pch::get_command_line( const clang::tooling::CompileCommand& command,
+                                                const std::string& output ) const
+{
+	// The source is replaced by the header, which goes last so no other -x applies to it
+	auto args = clang::tooling::getClangStripOutputAdjuster()( command.CommandLine, command.Filename );
+	args.erase( std::remove( args.begin() + 1, args.end(), command.Filename ), args.end() );
+	args.insert( args.end(), { "-o", output, "-xc++-header", header } );
+	return args;
+}
+
+
+bool Pch::load()
+{
+	llvm::SmallString<256> deps{ path };
+	llvm::sys::path::replace_extension( deps, "pchd" );
+
+	auto buffer = llvm::MemoryBuffer::getFile( deps );
+	if ( !buffer || !llvm::sys::fs::exists( path ) )
+	{
+		return false;
+	}
+
+	auto data = ( *buffer )->getBuffer();
+	if ( !data.startswith( pch_magic ) )
+	{
+		return false;
+	}
+	data = data.drop_front( sizeof( pch_magic ) - 1 );
+
+	// Every dependency is stored on its own line, after the hash of its contents
+	std::vector<std::string> paths;
+	while ( !data.empty() )
+	{
+		auto line = data.split( '\n' );
+		data      = line.second;
+
+		auto digest = line.first.split( ' ' );
+		auto file   = digest.second.str();
+		if ( digest.second.empty() || hash_file( file ) != digest.first )
+		{
+			return false;
+		}
+		paths.emplace_back( std::move( file ) );
+	}
+
+	dependencies = std::move( paths );
+	return true;
+}
+
+
+bool Pch::build( const clang::tooling::CompileCommand& command )
+{
+	llvm::SmallString<256> output;
+	if ( dir.empty() )
+	{
+		if ( llvm::sys::fs::createTemporaryFile( "pywrap", "pch", output ) )
+		{
+			return false;
+		}
+		path = output.str().str();
+	}
+	else
+	{
+		// Headers built with different options are kept apart
+		llvm::MD5 hash;
+		hash.update( pch_magic );
+		hash.update( command.Directory );
+		hash.update( llvm::StringRef{ "\0", 1 } );
+		for ( auto& arg : get_command_line( command, "" ) )
+		{
+			hash.update( arg );
+			hash.update( llvm::StringRef{ "\0", 1 } );
+		}
+		llvm::MD5::MD5Result digest;
+		hash.final( digest );
+
+		llvm::SmallString<256> kept{ dir };
+		llvm::sys::path::append( kept, digest.digest().str() + ".pch" );
+		path = kept.str().str();
+
+		if ( load() )
+		{
+			return true;
+		}
+
+		// Write to a temporary file first, so concurrent runs never see half a header
+		if ( llvm::sys::fs::createUniqueFile( dir + "/%%%%%%%%.tmp", output ) )
+		{
+			return false;
+		}
+	}
+
+	// Relative paths are relative to the directory of the compile command
+	llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> fs{ llvm::vfs::createPhysicalFileSystem().release() };
+	fs->setCurrentWorkingDirectory( command.Directory );
+	llvm::IntrusiveRefCntPtr<clang::FileManager> files{ new clang::FileManager{ clang::FileSystemOptions{}, fs } };
+
+	PchActionFactory               factory;
+	clang::tooling::ToolInvocation invocation{ get_command_line( command, output.str().str() ), &factory, files.get() };
+	if ( !invocation.run() )
+	{
+		llvm::sys::fs::remove( output );
+		return false;
+	}
+
+	dependencies.clear();
+	for ( auto& dependency : factory.get_dependencies() )
+	{
+		llvm::SmallString<256> file{ dependency };
+		if ( llvm::sys::path::is_relative( file ) )
+		{
+			file = command.Directory;
+			llvm::sys::path::append( file, dependency );
+		}
+		llvm::sys::path::remove_dots( file, /* remove_dot_dot = */ true );
+		dependencies.emplace_back( file.str().str() );
+	}
+
+	if ( dir.empty() )
+	{
+		return true;
+	}
+
+	// Stale dependencies go first, then the header goes in place before its new dependencies, which make it valid
+	llvm::SmallString<256> deps{ path };
+	llvm::sys::path::replace_extension( deps, "pchd" );
+	llvm::sys::fs::remove( deps );
+	if ( llvm::sys::fs::rename( output, path ) )
+	{
+		llvm::sys::fs::remove( output );
+		return false;
+	}
+
+	int                    fd = 0;
+	llvm::SmallString<256> temp;
+	if ( llvm::sys::fs::createUniqueFile( dir + "/%%%%%%%%.tmp", fd, temp ) )
+	{
+		return true;
+	}
+	{
+		llvm::raw_fd_ostream file{ fd, /* shouldClose = */ true };
+		file << pch_magic;
+		for ( auto& dependency : dependencies )
+		{
+			file << hash_file( dependency ) << ' ' << dependency << '\n';
+		}
+	}
+
+	if ( llvm::sys::fs::rename( temp, deps ) )
+	{
+		llvm::sys::fs::remove( temp );
+	}
+	return true;
+}
+
+
+}  // namespace pywrap
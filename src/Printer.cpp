@@ -1,119 +1,253 @@
 #include "pywrap/Printer.h"
 
+#include <llvm/Support/DJB.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+
 
 namespace pywrap
 {
-#define OPEN_FILE_STREAM( file, name )                                                  \
-	std::error_code      error;                                                         \
-	llvm::raw_fd_ostream file{ name, error, llvm::sys::fs::F_None };                    \
-	if ( error )                                                                        \
-	{                                                                                   \
-		llvm::errs() << " while opening '" << name << "': " << error.message() << '\n'; \
-		exit( 1 );                                                                      \
+/// Gives hidden visibility to the declarations which follow, up to the pop
+static const char* push_hidden = "\n#if defined( __GNUC__ )\n#pragma GCC visibility push( hidden )\n#endif\n\n";
+
+static const char* pop_hidden = "\n#if defined( __GNUC__ )\n#pragma GCC visibility pop\n#endif\n\n";
+
+
+/// Estimates the symbols of generated code from its text, as every declaration ends a line with a semicolon
+/// @param[in] code Generated declarations
+/// @return The number of declarations, each ending a line
+static size_t count_decls( const std::string& code )
+{
+	size_t ret = 0;
+	for ( auto pos = code.find( ";\n" ); pos != std::string::npos; pos = code.find( ";\n", pos + 1 ) )
+	{
+		++ret;
+	}
+	return ret;
+}
+
+
+/// @return Whether two files exist and have the same contents
+static bool equal_files( llvm::StringRef a, llvm::StringRef b )
+{
+	uint64_t a_size = 0;
+	uint64_t b_size = 0;
+	if ( llvm::sys::fs::file_size( a, a_size ) || llvm::sys::fs::file_size( b, b_size ) || a_size != b_size )
+	{
+		return false;
+	}
+
+	// Without a null terminator large files are mapped rather than read into memory
+	auto a_buffer = llvm::MemoryBuffer::getFile( a, -1, /* RequiresNullTerminator = */ false );
+	auto b_buffer = llvm::MemoryBuffer::getFile( b, -1, /* RequiresNullTerminator = */ false );
+	return a_buffer && b_buffer && ( *a_buffer )->getBuffer() == ( *b_buffer )->getBuffer();
+}
+
+
+void Printer::replace_if_changed( llvm::StringRef name, llvm::StringRef temp )
+{
+	if ( equal_files( temp, name ) )
+	{
+		// Leave it untouched, so its modification time does not trigger a rebuild
+		llvm::sys::fs::remove( temp );
+		unchanged.emplace_back( name.str() );
+		return;
+	}
+
+	if ( auto error = llvm::sys::fs::rename( temp, name ) )
+	{
+		llvm::sys::fs::remove( temp );
+		llvm::errs() << " while writing '" << name << "': " << error.message() << '\n';
+		exit( 1 );
 	}
+}
+
+
+void Printer::print_file( llvm::StringRef name, PrintFunc print )
+{
+	// Stream next to the output, so the generated code is never held in memory
+	// and a build never sees half a file
+	int                    fd = 0;
+	llvm::SmallString<128> temp;
+	if ( auto error = llvm::sys::fs::createUniqueFile( name + ".%%%%%%.tmp", fd, temp ) )
+	{
+		llvm::errs() << " while opening '" << name << "': " << error.message() << '\n';
+		exit( 1 );
+	}
+
+	{
+		llvm::raw_fd_ostream file{ fd, /* shouldClose = */ true };
+		( this->*print )( file, name );
+	}
+
+	replace_if_changed( name, temp );
+	outputs.emplace_back( name.str() );
+}
+
+
+void Printer::print_wrapper_decl( llvm::raw_ostream& os, const ir::Binding& tag )
+{
+	auto& name = tag.qualified_name;
+	auto  sign = "template<>\npyspot::Wrapper<" + name + ">::Wrapper( ";
+
+	// Pointer, copy and move constructors
+	os << sign << name << "* v );\n\n";
+	os << sign << "const " << name << "& v );\n\n";
+	os << sign << name << "&& v );\n\n";
+}
+
+
+void Printer::print_reg( llvm::raw_ostream& os, const ir::Module& module, const ir::Binding& tag )
+{
+	auto type_object_name = tag.py_name + "_type_object";
+
+	os << "\tif ( PyType_Ready( &" << type_object_name << " ) < 0 )\n"
+	   << "\t{\n\t\treturn nullptr;\n\t}\n"
+	   << "\tPy_INCREF( &" << type_object_name << " );\n"
+	   << "\tPyModule_AddObject( " << module.py_name << ", \"" << tag.name << "\", "
+	   << "reinterpret_cast<PyObject*>( &" << type_object_name << " ) );\n\n";
+
+	// Enum constants are wrapped into the dictionary of the type
+	auto& name = tag.qualified_name;
+	for ( auto& constant : tag.constants )
+	{
+		os << "\tPyDict_SetItemString( " << type_object_name << ".tp_dict, \"" << constant << "\", pyspot::Wrapper<"
+		   << name << ">{ " << name << "::" << constant << " }.GetIncref() );\n";
+	}
+}
+
 
-void Printer::process_includes( llvm::raw_fd_ostream& file, const binding::Module& module )
+void Printer::print_method( llvm::raw_ostream& os, const ir::Binding& function )
+{
+	auto flags = function.params.empty() ? "METH_NOARGS" : "METH_VARARGS | METH_KEYWORDS";
+	os << "\t{ \"" << function.name << "\", " << function.py_name << ", " << flags << ", \"" << function.name
+	   << "\" },\n";
+}
+
+
+void Printer::print_module_reg( llvm::raw_ostream& os, const ir::Module& parent, const ir::Module& module )
+{
+	auto& py_name        = module.py_name;
+	auto  exception      = py_name + "_exception";
+	auto  exception_name = py_name + "_" + exception;
+
+	os << "\tauto " << py_name << " = PyModule_Create( &" << py_name << "_module_def );\n\n";
+
+	os << "\tstatic char " << exception_name << "[] = { \"" << module.name << ".exception\" };\n"
+	   << "\tauto " << exception << " = PyErr_NewException( " << exception_name << ", NULL, NULL );\n"
+	   << "\tPy_INCREF( " << exception << " );\n"
+	   << "\tPyModule_AddObject( " << py_name << ", \"" << exception << "\", " << exception << " );\n\n";
+
+	os << "\tPyModule_AddObject( " << parent.py_name << ", \"" << module.name << "\", " << py_name << " );\n\n";
+}
+
+
+void Printer::process_includes( llvm::raw_ostream& file, const ir::Module& module )
 {
 	// Nested modules
-	for ( auto& child : module.get_modules() )
+	for ( auto& child : module.modules )
 	{
 		process_includes( file, child );
 	}
 
-	auto process_include = [&file, this]( const binding::Binding& b ) {
-		auto incl = b.get_incl();
-		auto it   = processed_includes.find( incl );
+	auto process_include = [&file, this]( const ir::Binding& b ) {
+		auto it = processed_includes.find( b.incl );
 		if ( it == processed_includes.end() )
 		{
-			file << "#include \"" << incl << "\"\n";
-			processed_includes.emplace( incl );
+			file << "#include \"" << b.incl << "\"\n";
+			processed_includes.emplace( b.incl );
 		}
 	};
 
-	for ( auto& function : module.get_functions() )
+	for ( auto& function : module.functions )
 	{
 		process_include( function );
 	}
 
-	if ( !module.get_enums().empty() )
+	for ( auto& en : module.enums )
 	{
-		for ( auto& en : module.get_enums() )
-		{
-			process_include( en );
-		}
+		process_include( en );
 	}
 
-	for ( auto& templ : module.get_templates() )
+	for ( auto& templ : module.templates )
 	{
 		process_include( templ );
 	}
 
-	for ( auto& spec : module.get_specializations() )
+	for ( auto& spec : module.specializations )
 	{
 		process_include( spec );
 	}
-	for ( auto& record : module.get_records() )
+	for ( auto& record : module.records )
 	{
 		process_include( record );
 	}
 }
 
-void Printer::process_decls( llvm::raw_fd_ostream& file, const binding::Module& module )
+void Printer::process_decls( llvm::raw_ostream& file, const ir::Module& module )
 {
 	// Nested modules
-	for ( auto& child : module.get_modules() )
+	for ( auto& child : module.modules )
 	{
 		process_decls( file, child );
 	}
 
-	auto print_decl = [&file]( const binding::Binding& b ) { file << b.get_decl() << '\n'; };
+	auto print_decl = [&file]( const ir::Binding& b ) {
+		for ( auto& field : b.fields )
+		{
+			file << field.decl;
+		}
+		file << b.decl << '\n';
+	};
 
 	// Functions
-	auto& functions = module.get_functions();
+	auto& functions = module.functions;
 	std::for_each( std::begin( functions ), std::end( functions ), print_decl );
 
 	// Enums
-	auto& enums = module.get_enums();
+	auto& enums = module.enums;
 	std::for_each( std::begin( enums ), std::end( enums ), print_decl );
 
 	// Templates
-	auto& templates = module.get_templates();
+	auto& templates = module.templates;
 	std::for_each( std::begin( templates ), std::end( templates ), print_decl );
 
 	// Specializations
-	auto& specializations = module.get_specializations();
+	auto& specializations = module.specializations;
 	std::for_each( std::begin( specializations ), std::end( specializations ), print_decl );
 
 	// Structs, unions, classes
-	auto& records = module.get_records();
+	auto& records = module.records;
 	std::for_each( std::begin( records ), std::end( records ), print_decl );
 }
 
 
-void Printer::process_wrappers( llvm::raw_fd_ostream& file, const binding::Module& module )
+void Printer::process_wrappers( llvm::raw_ostream& file, const ir::Module& module )
 {
 	// Nested modules
-	for ( auto& child : module.get_modules() )
+	for ( auto& child : module.modules )
 	{
 		process_wrappers( file, child );
 	}
 
-	auto print_wrapper_decl = [&file]( const binding::Tag& b ) { file << b.get_wrapper().get_decl() << '\n'; };
+	auto print_wrapper_decl = [&file]( const ir::Binding& b ) {
+		Printer::print_wrapper_decl( file, b );
+		file << '\n';
+	};
 
-	auto& enums = module.get_enums();
+	auto& enums = module.enums;
 	std::for_each( std::begin( enums ), std::end( enums ), print_wrapper_decl );
 
-	auto& specializations = module.get_specializations();
+	auto& specializations = module.specializations;
 	std::for_each( std::begin( specializations ), std::end( specializations ), print_wrapper_decl );
 
-	auto& records = module.get_records();
+	auto& records = module.records;
 	std::for_each( std::begin( records ), std::end( records ), print_wrapper_decl );
 }
 
-void Printer::print_bindings_header( llvm::StringRef name )
+void Printer::print_bindings_header( llvm::raw_ostream& file, llvm::StringRef name )
 {
-	OPEN_FILE_STREAM( file, name );
-
 	// Guards
 	file << "#ifndef PYSPOT_BINDINGS_H_\n#define PYSPOT_BINDINGS_H_\n\n";
 
@@ -126,6 +260,12 @@ void Printer::print_bindings_header( llvm::StringRef name )
 	// Tail includes
 	file << "\n#include <pyspot/Wrapper.h>\n#include <structmember.h>\n\n";
 
+	// Everything declared by pywrap is only used within the extension
+	if ( hidden_symbols )
+	{
+		file << push_hidden;
+	}
+
 	// Extern C
 	file << "\n#ifdef __cplusplus\nextern \"C\" {\n#endif // __cplusplus\n\n";
 
@@ -144,61 +284,120 @@ void Printer::print_bindings_header( llvm::StringRef name )
 		process_wrappers( file, pr.second );
 	}
 
+	// Converters shared by the shards
+	for ( auto& pr : converters )
+	{
+		file << pr.second.first->decl;
+	}
+
+	if ( hidden_symbols )
+	{
+		file << pop_hidden;
+	}
+
 	// End guards
 	file << "\n#endif // PYSPOT_BINDINGS_H_\n";
 }
 
-void Printer::process_defs( llvm::raw_fd_ostream& file, const binding::Module& module )
+void Printer::process_defs( llvm::raw_ostream& file, const ir::Module& module )
 {
 	// Nested modules
-	for ( auto& child : module.get_modules() )
+	for ( auto& child : module.modules )
 	{
 		process_defs( file, child );
 	}
 
-	auto print_def = [&]( const binding::Binding& b ) { file << b.get_def() << '\n'; };
+	auto print_def = [&]( const ir::Binding& b ) {
+		if ( !in_shard( module, b ) )
+		{
+			return;
+		}
+
+		for ( auto& field : b.fields )
+		{
+			file << field.def;
+		}
+		file << b.def;
+
+		// Cases close the __class_getitem__ of a template
+		for ( auto& item : b.items )
+		{
+			file << item.def;
+		}
+		if ( b.kind == ir::Kind::Template )
+		{
+			file << "\treturn nullptr;\n}\n\n";
+		}
+		file << '\n';
+	};
 
 	// Functions
-	auto& functions = module.get_functions();
+	auto& functions = module.functions;
 	std::for_each( functions.begin(), functions.end(), print_def );
 
 	// Enums
-	auto& enums = module.get_enums();
+	auto& enums = module.enums;
 	std::for_each( enums.begin(), enums.end(), print_def );
 
 	// Templates
-	auto& templates = module.get_templates();
+	auto& templates = module.templates;
 	std::for_each( templates.begin(), templates.end(), print_def );
 
 	// Specializations
-	auto& specializations = module.get_specializations();
+	auto& specializations = module.specializations;
 	std::for_each( specializations.begin(), specializations.end(), print_def );
 
 	// CXXRecord
-	auto& records = module.get_records();
+	auto& records = module.records;
 	std::for_each( records.begin(), records.end(), print_def );
 }
 
 
-void Printer::print_bindings_source( llvm::StringRef name )
+bool Printer::in_shard( const ir::Module& module, const ir::Binding& binding ) const
 {
-	OPEN_FILE_STREAM( file, name );
+	if ( shard_by_module )
+	{
+		return module.id == shard_module;
+	}
+
+	// A stable hash, so a binding stays in its shard across runs
+	return shard_count == 1 || llvm::djbHash( binding.id ) % shard_count == shard;
+}
+
+
+void Printer::print_bindings_source( llvm::raw_ostream& file, llvm::StringRef name )
+{
+	// Shards share the same header
+	file << "#include \"pyspot/Bindings.h\"\n\n#include <string>\n#include <Python.h>\n#include <pyspot/String.h>\n\n\n";
+
+	if ( hidden_symbols )
+	{
+		file << push_hidden;
+	}
 
-	auto include = name.slice( 4, name.size() - 3 );
-	file << "#include \"" << include.str()
-	     << "h\"\n\n#include <string>\n#include <Python.h>\n#include <pyspot/String.h>\n\n\n";
+	// Every converter is defined by a single shard
+	for ( auto& pr : converters )
+	{
+		if ( in_shard( *pr.second.second, *pr.second.first ) )
+		{
+			file << pr.second.first->def;
+		}
+	}
 
 	for ( auto& pr : *modules )
 	{
 		process_defs( file, pr.second );
 	}
+
+	if ( hidden_symbols )
+	{
+		file << pop_hidden;
+	}
 }
 
 
-void Printer::print_extension_header( llvm::StringRef name )
+void Printer::print_extension_header( llvm::raw_ostream& file, llvm::StringRef name )
 {
-	OPEN_FILE_STREAM( file, name );
-
 	// Guards
 	file << "#ifndef PYSPOT_EXTENSION_H_\n"
 	        "#define PYSPOT_EXTENSION_H_\n\n"
@@ -211,7 +410,18 @@ void Printer::print_extension_header( llvm::StringRef name )
 	for ( auto& pr : *modules )
 	{
 		auto& module = pr.second;
-		file << module.get_decl();
+		file << module.decl;
+	}
+
+	// Init functions stay exported, even when their definitions follow a push of hidden visibility
+	if ( hidden_symbols )
+	{
+		file << "#if defined( __GNUC__ )\n";
+		for ( auto& pr : *modules )
+		{
+			file << "__attribute__( ( visibility( \"default\" ) ) ) PyObject* PyInit_" << pr.second.name << "();\n";
+		}
+		file << "#endif\n";
 	}
 
 	// End extern C
@@ -222,46 +432,218 @@ void Printer::print_extension_header( llvm::StringRef name )
 }
 
 
-void Printer::print_extension_source( llvm::StringRef name )
+void Printer::print_extension_source( llvm::raw_ostream& file, llvm::StringRef name )
 {
-	OPEN_FILE_STREAM( file, name );
-
 	file << "#include \"" << name.slice( 4, name.size() - 3 ).str() << "h\"\n\n"
 	     << "#include \"pyspot/Bindings.h\"\n\n"
 	     << "struct ModuleState\n{\n"
 	     << "\tPyObject* error;\n};\n\n";
 
-	std::function<void( const binding::Module& )> process_module_defs =
-	    [&file, &process_module_defs]( const binding::Module& module ) {
-		    for ( auto& child : module.get_modules() )
-		    {
-			    process_module_defs( child );
-		    }
-		    file << module.get_methods().get_def();
-		    file << module.get_def();
-	    };
+	if ( hidden_symbols )
+	{
+		file << push_hidden;
+	}
+
+	std::function<void( const ir::Module& )> process_module_defs = [&file, &process_module_defs,
+	                                                                 this]( const ir::Module& module ) {
+		for ( auto& child : module.modules )
+		{
+			process_module_defs( child );
+		}
+
+		// Methods map
+		file << module.methods;
+		for ( auto& function : module.functions )
+		{
+			print_method( file, function );
+		}
+		file << "\t{ NULL, NULL, 0, NULL } // sentinel\n};\n\n";
+
+		file << module.def;
+
+		// Close init function if not nested module
+		if ( !module.nested )
+		{
+			process_regs( file, module );
+			for ( auto& child : module.modules )
+			{
+				print_module_reg( file, module, child );
+				process_regs( file, child );
+			}
+
+			file << "\treturn " << module.py_name << ";\n}\n";
+		}
+	};
 
 	for ( auto& pr : *modules )
 	{
 		process_module_defs( pr.second );
 	}
+
+	if ( hidden_symbols )
+	{
+		file << pop_hidden;
+	}
 }
 
 
-void Printer::print_out( const std::unordered_map<std::string, binding::Module>& m )
+void Printer::collect_converters( const ir::Module& module )
+{
+	for ( auto& child : module.modules )
+	{
+		collect_converters( child );
+	}
+
+	for ( auto& converter : module.converters )
+	{
+		converters.emplace( converter.id, std::make_pair( &converter, &module ) );
+	}
+}
+
+
+void Printer::count_symbols( const ir::Module& module )
+{
+	for ( auto& child : module.modules )
+	{
+		count_symbols( child );
+	}
+
+	// Description, definition and methods of the module, as printed by print_extension_source
+	symbols.total += 3;
+
+	// Pointer, copy and move constructors of the wrappers, as printed by print_wrapper_decl
+	symbols.total += 3 * ( module.enums.size() + module.specializations.size() + module.records.size() );
+
+	for ( auto bindings :
+	      { &module.functions, &module.enums, &module.templates, &module.specializations, &module.records } )
+	{
+		for ( auto& binding : *bindings )
+		{
+			symbols.total += count_decls( binding.decl );
+			for ( auto& field : binding.fields )
+			{
+				symbols.total += count_decls( field.decl );
+			}
+		}
+	}
+}
+
+
+void Printer::process_regs( llvm::raw_ostream& file, const ir::Module& module )
+{
+	auto print_reg = [&file, &module]( const ir::Binding& b ) { Printer::print_reg( file, module, b ); };
+
+	std::for_each( module.enums.begin(), module.enums.end(), print_reg );
+	std::for_each( module.templates.begin(), module.templates.end(), print_reg );
+	std::for_each( module.specializations.begin(), module.specializations.end(), print_reg );
+	std::for_each( module.records.begin(), module.records.end(), print_reg );
+}
+
+
+void Printer::print_out( const ir::Modules& m )
 {
 	// TODO make member variable
 	modules = &m;
+	unchanged.clear();
+	outputs.clear();
+
+	converters.clear();
+	for ( auto& pr : m )
+	{
+		collect_converters( pr.second );
+	}
+
+	symbols = {};
+	for ( auto& pr : m )
+	{
+		// Module init function, which is always exported
+		symbols.total += 1;
+		symbols.exported += 1;
+		count_symbols( pr.second );
+	}
+	for ( auto& pr : converters )
+	{
+		symbols.total += count_decls( pr.second.first->decl );
+	}
+	if ( !hidden_symbols )
+	{
+		symbols.exported = symbols.total;
+	}
 
 	llvm::sys::fs::create_directory( "include" );
 	llvm::sys::fs::create_directory( "src" );
 	llvm::sys::fs::create_directory( "include/pyspot" );
 	llvm::sys::fs::create_directory( "src/pyspot" );
 
-	print_bindings_header( "include/pyspot/Bindings.h" );
-	print_bindings_source( "src/pyspot/Bindings.cpp" );
-	print_extension_header( "include/pyspot/Extension.h" );
-	print_extension_source( "src/pyspot/Extension.cpp" );
+	print_file( "include/pyspot/Bindings.h", &Printer::print_bindings_header );
+	remove_stale_sources( print_bindings_sources() );
+	print_file( "include/pyspot/Extension.h", &Printer::print_extension_header );
+	print_file( "src/pyspot/Extension.cpp", &Printer::print_extension_source );
+}
+
+
+std::set<std::string> Printer::print_bindings_sources()
+{
+	std::set<std::string> printed;
+
+	if ( shard_by_module )
+	{
+		std::function<void( const ir::Module& )> print_module = [&]( const ir::Module& module ) {
+			for ( auto& child : module.modules )
+			{
+				print_module( child );
+			}
+
+			if ( module.functions.empty() && module.enums.empty() && module.templates.empty() &&
+			     module.specializations.empty() && module.records.empty() )
+			{
+				return;
+			}
+
+			shard_module = module.id;
+			auto name    = "src/pyspot/Bindings_" + module.py_name + ".cpp";
+			print_file( name, &Printer::print_bindings_source );
+			printed.emplace( std::move( name ) );
+		};
+
+		for ( auto& pr : *modules )
+		{
+			print_module( pr.second );
+		}
+	}
+	else if ( shard_count > 1 )
+	{
+		for ( shard = 0; shard < shard_count; ++shard )
+		{
+			auto name = "src/pyspot/Bindings_" + std::to_string( shard ) + ".cpp";
+			print_file( name, &Printer::print_bindings_source );
+			printed.emplace( std::move( name ) );
+		}
+	}
+	else
+	{
+		std::string name = "src/pyspot/Bindings.cpp";
+		print_file( name, &Printer::print_bindings_source );
+		printed.emplace( std::move( name ) );
+	}
+
+	return printed;
+}
+
+
+void Printer::remove_stale_sources( const std::set<std::string>& printed )
+{
+	// Shards left over by a previous run with a different configuration
+	std::error_code error;
+	for ( llvm::sys::fs::directory_iterator it{ "src/pyspot", error }, end; it != end && !error; it.increment( error ) )
+	{
+		auto filename = llvm::sys::path::filename( it->path() );
+		if ( filename.startswith( "Bindings" ) && filename.endswith( ".cpp" ) &&
+		     printed.find( "src/pyspot/" + filename.str() ) == printed.end() )
+		{
+			llvm::sys::fs::remove( it->path() );
+		}
+	}
 }
 
 
@@ -0,0 +1,443 @@
+#include "pywrap/Profile.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include <llvm/Support/Format.h>
+#include <llvm/Support/FormatVariadic.h>
+#include <llvm/Support/JSON.h>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <ctime>
+#include <sys/resource.h>
+#endif
+
+
+namespace pywrap
+{
+/// @return CPU time of the calling thread, in seconds
+static double get_thread_cpu_time()
+{
+#ifdef _WIN32
+	FILETIME creation, end, kernel, user;
+	if ( !GetThreadTimes( GetCurrentThread(), &creation, &end, &kernel, &user ) )
+	{
+		return 0.0;
+	}
+	// Both are in units of 100 nanoseconds
+	auto to_ticks = []( const FILETIME& t ) {
+		return ( static_cast<uint64_t>( t.dwHighDateTime ) << 32 ) | t.dwLowDateTime;
+	};
+	return ( to_ticks( kernel ) + to_ticks( user ) ) * 1e-7;
+#else
+	timespec ts;
+	if ( clock_gettime( CLOCK_THREAD_CPUTIME_ID, &ts ) != 0 )
+	{
+		return 0.0;
+	}
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+
+size_t get_peak_memory()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if ( !GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) ) )
+	{
+		return 0;
+	}
+	return counters.PeakWorkingSetSize;
+#else
+	rusage usage;
+	if ( getrusage( RUSAGE_SELF, &usage ) != 0 )
+	{
+		return 0;
+	}
+#ifdef __APPLE__
+	return usage.ru_maxrss;
+#else
+	// Linux reports kilobytes
+	return static_cast<size_t>( usage.ru_maxrss ) * 1024;
+#endif
+#endif
+}
+
+
+Time Time::now()
+{
+	auto wall = std::chrono::duration<double>( std::chrono::steady_clock::now().time_since_epoch() );
+	return { wall.count(), get_thread_cpu_time() };
+}
+
+
+Time& TimeReport::get_phase( const std::string& name )
+{
+	auto it = std::find_if( phases.begin(), phases.end(),
+	                        [&name]( const std::pair<std::string, Time>& phase ) { return phase.first == name; } );
+	if ( it == phases.end() )
+	{
+		phases.emplace_back( name, Time{} );
+		return phases.back().second;
+	}
+	return it->second;
+}
+
+
+std::vector<const UnitProfile*> TimeReport::get_slowest_units( const size_t count ) const
+{
+	std::vector<const UnitProfile*> ret;
+	for ( auto& unit : units )
+	{
+		ret.emplace_back( &unit );
+	}
+
+	std::stable_sort( ret.begin(), ret.end(),
+	                  []( const UnitProfile* a, const UnitProfile* b ) { return a->total.wall > b->total.wall; } );
+	ret.resize( std::min( count, ret.size() ) );
+	return ret;
+}
+
+
+std::vector<std::pair<std::string, Time>> TimeReport::get_slowest_headers( const size_t count ) const
+{
+	std::unordered_map<std::string, Time> headers;
+	for ( auto& unit : units )
+	{
+		for ( auto& header : unit.headers )
+		{
+			headers[header.first] += header.second;
+		}
+	}
+
+	std::vector<std::pair<std::string, Time>> ret{ headers.begin(), headers.end() };
+	std::sort( ret.begin(), ret.end(), []( const std::pair<std::string, Time>& a, const std::pair<std::string, Time>& b ) {
+		return a.second.wall > b.second.wall || ( a.second.wall == b.second.wall && a.first < b.first );
+	} );
+	ret.resize( std::min( count, ret.size() ) );
+	return ret;
+}
+
+
+namespace
+{
+/// Sums of the profiles of every translation unit
+struct Totals
+{
+	Totals( const std::vector<UnitProfile>& units )
+	{
+		for ( auto& unit : units )
+		{
+			cached += unit.cached ? 1 : 0;
+			matched_decls += unit.matched_decls;
+			generated_bindings += unit.generated_bindings;
+			parse += unit.frontend - unit.match - unit.convert;
+			match += unit.match - unit.bindings;
+			bindings += unit.bindings;
+			convert += unit.convert;
+			ir += unit.ir;
+		}
+	}
+
+	size_t cached = 0;
+
+	size_t matched_decls = 0;
+
+	size_t generated_bindings = 0;
+
+	Time parse;
+
+	Time match;
+
+	Time bindings;
+
+	Time convert;
+
+	Time ir;
+};
+
+
+void print_row( llvm::raw_ostream& os, const Time& time, llvm::StringRef name )
+{
+	os << llvm::format( "%10.3f  %10.3f  ", time.wall, time.cpu ) << name << '\n';
+}
+
+
+}  // namespace
+
+
+void TimeReport::print( llvm::raw_ostream& os, const size_t slowest ) const
+{
+	os << "===-------------------------------------------------------------------------===\n"
+	   << "                             Pywrap time report\n"
+	   << "===-------------------------------------------------------------------------===\n\n";
+
+	os << "    Wall (s)     CPU (s)  Phase\n";
+	for ( auto& phase : phases )
+	{
+		print_row( os, phase.second, phase.first );
+	}
+
+	Totals totals{ units };
+	os << "\n    Wall (s)     CPU (s)  Summed over " << units.size() << " translation units (" << totals.cached
+	   << " cached)\n";
+	print_row( os, totals.parse, "parse" );
+	print_row( os, totals.match, "match" );
+	print_row( os, totals.bindings, "bindings" );
+	print_row( os, totals.convert, "convert" );
+	print_row( os, totals.ir, "ir" );
+	os << "\nMatched declarations: " << totals.matched_decls << "\nGenerated bindings: " << totals.generated_bindings
+	   << '\n';
+
+	os << "\n    Wall (s)     CPU (s)   Parse (s)   Match (s)  Decls  Bindings  Slowest translation units\n";
+	for ( auto unit : get_slowest_units( slowest ) )
+	{
+		os << llvm::format( "%10.3f  %10.3f  %10.3f  %10.3f  %5zu  %8zu  ", unit->total.wall, unit->total.cpu,
+		                    ( unit->frontend - unit->match - unit->convert ).wall, unit->match.wall, unit->matched_decls,
+		                    unit->generated_bindings )
+		   << unit->source << ( unit->cached ? " (cached)" : "" ) << '\n';
+	}
+
+	os << "\n    Wall (s)     CPU (s)  Slowest headers\n";
+	for ( auto& header : get_slowest_headers( slowest ) )
+	{
+		print_row( os, header.second, header.first );
+	}
+}
+
+
+static llvm::json::Value to_json( const Time& time )
+{
+	return llvm::json::Object{ { "wall", time.wall }, { "cpu", time.cpu } };
+}
+
+
+void TimeReport::print_json( llvm::raw_ostream& os, const size_t slowest ) const
+{
+	llvm::json::Object phases_json;
+	for ( auto& phase : phases )
+	{
+		phases_json[phase.first] = to_json( phase.second );
+	}
+
+	llvm::json::Array units_json;
+	for ( auto& unit : units )
+	{
+		units_json.push_back( llvm::json::Object{ { "source", unit.source },
+		                                          { "cached", unit.cached },
+		                                          { "total", to_json( unit.total ) },
+		                                          { "parse", to_json( unit.frontend - unit.match - unit.convert ) },
+		                                          { "match", to_json( unit.match - unit.bindings ) },
+		                                          { "bindings", to_json( unit.bindings ) },
+		                                          { "convert", to_json( unit.convert ) },
+		                                          { "ir", to_json( unit.ir ) },
+		                                          { "matched_decls", static_cast<int64_t>( unit.matched_decls ) },
+		                                          { "generated_bindings",
+		                                            static_cast<int64_t>( unit.generated_bindings ) } } );
+	}
+
+	llvm::json::Array slowest_units;
+	for ( auto unit : get_slowest_units( slowest ) )
+	{
+		slowest_units.push_back( unit->source );
+	}
+
+	llvm::json::Array slowest_headers;
+	for ( auto& header : get_slowest_headers( slowest ) )
+	{
+		slowest_headers.push_back(
+		    llvm::json::Object{ { "path", header.first }, { "time", to_json( header.second ) } } );
+	}
+
+	Totals totals{ units };
+	llvm::json::Object root{ { "phases", std::move( phases_json ) },
+		                     { "totals", llvm::json::Object{ { "parse", to_json( totals.parse ) },
+		                                                     { "match", to_json( totals.match ) },
+		                                                     { "bindings", to_json( totals.bindings ) },
+		                                                     { "convert", to_json( totals.convert ) },
+		                                                     { "ir", to_json( totals.ir ) },
+		                                                     { "cached", static_cast<int64_t>( totals.cached ) },
+		                                                     { "matched_decls",
+		                                                       static_cast<int64_t>( totals.matched_decls ) },
+		                                                     { "generated_bindings",
+		                                                       static_cast<int64_t>( totals.generated_bindings ) } } },
+		                     { "units", std::move( units_json ) },
+		                     { "slowest_units", std::move( slowest_units ) },
+		                     { "slowest_headers", std::move( slowest_headers ) } };
+	os << llvm::formatv( "{0:2}", llvm::json::Value{ std::move( root ) } ) << '\n';
+}
+
+
+namespace
+{
+/// @return The bytes a string holds on the heap, if it does not fit within the object
+size_t get_heap_size( const std::string& str )
+{
+	static const auto inline_capacity = std::string{}.capacity();
+	return str.capacity() > inline_capacity ? str.capacity() + 1 : 0;
+}
+
+
+/// @return The bytes a vector of strings and its strings hold on the heap
+size_t get_heap_size( const std::vector<std::string>& strs )
+{
+	auto ret = strs.capacity() * sizeof( std::string );
+	for ( auto& str : strs )
+	{
+		ret += get_heap_size( str );
+	}
+	return ret;
+}
+
+
+template <typename T>
+size_t get_unused_size( const std::vector<T>& vec )
+{
+	return ( vec.capacity() - vec.size() ) * sizeof( T );
+}
+
+
+double to_mib( size_t bytes )
+{
+	return bytes / ( 1024.0 * 1024.0 );
+}
+
+
+}  // namespace
+
+
+void MemoryReport::add_phase( const std::string& name )
+{
+	phases.emplace_back( name, get_peak_memory() );
+}
+
+
+void MemoryReport::add_largest( const ir::Binding& binding, const size_t bytes )
+{
+	auto greater = []( const std::pair<size_t, std::string>& a, const std::pair<size_t, std::string>& b ) {
+		return a.first > b.first;
+	};
+
+	if ( largest.size() < largest_count )
+	{
+		largest.emplace_back( bytes, std::string{ ir::to_string( binding.kind ) } + " " + binding.id );
+		std::push_heap( largest.begin(), largest.end(), greater );
+	}
+	else if ( largest_count > 0 && bytes > largest.front().first )
+	{
+		std::pop_heap( largest.begin(), largest.end(), greater );
+		largest.back() = { bytes, std::string{ ir::to_string( binding.kind ) } + " " + binding.id };
+		std::push_heap( largest.begin(), largest.end(), greater );
+	}
+}
+
+
+size_t MemoryReport::add_binding( const ir::Binding& binding )
+{
+	size_t bytes = sizeof( binding ) + get_heap_size( binding.id ) + get_heap_size( binding.name ) +
+	               get_heap_size( binding.qualified_name ) + get_heap_size( binding.py_name ) +
+	               get_heap_size( binding.type ) + get_heap_size( binding.params ) +
+	               get_heap_size( binding.constants ) + get_heap_size( binding.args ) + get_heap_size( binding.incl ) +
+	               get_heap_size( binding.decl ) + get_heap_size( binding.def ) + get_unused_size( binding.fields ) +
+	               get_unused_size( binding.items );
+	for ( auto& item : binding.items )
+	{
+		bytes += sizeof( item ) + get_heap_size( item.id ) + get_heap_size( item.def );
+	}
+
+	auto& usage = kinds[static_cast<size_t>( binding.kind )];
+	++usage.count;
+	usage.bytes += bytes;
+
+	// Fields count on their own, while a record is listed with its fields
+	size_t total = bytes;
+	for ( auto& field : binding.fields )
+	{
+		total += add_binding( field );
+	}
+	if ( binding.kind != ir::Kind::Field )
+	{
+		add_largest( binding, total );
+	}
+
+	return bytes;
+}
+
+
+void MemoryReport::add_module( const ir::Module& module )
+{
+	++modules.count;
+	modules.bytes += sizeof( module ) + get_heap_size( module.id ) + get_heap_size( module.name ) +
+	                 get_heap_size( module.py_name ) + get_heap_size( module.decl ) + get_heap_size( module.def ) +
+	                 get_heap_size( module.methods ) + get_unused_size( module.modules ) +
+	                 get_unused_size( module.functions ) + get_unused_size( module.enums ) +
+	                 get_unused_size( module.templates ) + get_unused_size( module.specializations ) +
+	                 get_unused_size( module.records ) + get_unused_size( module.converters );
+
+	for ( auto& child : module.modules )
+	{
+		add_module( child );
+	}
+	for ( auto bindings : { &module.functions, &module.enums, &module.templates, &module.specializations,
+	                        &module.records, &module.converters } )
+	{
+		for ( auto& binding : *bindings )
+		{
+			add_binding( binding );
+		}
+	}
+}
+
+
+void MemoryReport::add_modules( const ir::Modules& mods )
+{
+	for ( auto& pr : mods )
+	{
+		add_module( pr.second );
+	}
+}
+
+
+void MemoryReport::print( llvm::raw_ostream& os ) const
+{
+	os << "===-------------------------------------------------------------------------===\n"
+	   << "                            Pywrap memory report\n"
+	   << "===-------------------------------------------------------------------------===\n\n";
+
+	os << "   Peak (MiB)  Growth (MiB)  Phase\n";
+	size_t previous = 0;
+	for ( auto& phase : phases )
+	{
+		auto growth = phase.second > previous ? phase.second - previous : 0;
+		os << llvm::format( "%13.1f  %12.1f  ", to_mib( phase.second ), to_mib( growth ) ) << phase.first << '\n';
+		previous = std::max( previous, phase.second );
+	}
+
+	os << "\n        Count    Bytes held  Kind\n";
+	os << llvm::format( "%13zu  %12zu  ", modules.count, modules.bytes ) << "module\n";
+	for ( size_t i = 0; i < kinds.size(); ++i )
+	{
+		os << llvm::format( "%13zu  %12zu  ", kinds[i].count, kinds[i].bytes )
+		   << ir::to_string( static_cast<ir::Kind>( i ) ) << '\n';
+	}
+
+	auto sorted = largest;
+	std::sort( sorted.begin(), sorted.end(), []( const std::pair<size_t, std::string>& a,
+	                                             const std::pair<size_t, std::string>& b ) {
+		return a.first > b.first || ( a.first == b.first && a.second < b.second );
+	} );
+
+	os << "\n                Bytes held  Largest bindings, including their fields\n";
+	for ( auto& binding : sorted )
+	{
+		os << llvm::format( "%26zu  ", binding.first ) << binding.second << '\n';
+	}
+}
+
+
+}  // namespace pywrap
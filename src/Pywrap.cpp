@@ -1,29 +1,649 @@
 #include "pywrap/Pywrap.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "clang/Driver/Options.h"
+#include "clang/Tooling/ArgumentsAdjusters.h"
 #include "llvm/Option/OptTable.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Program.h"
+#include "llvm/Support/Regex.h"
+
+
+static llvm::cl::OptionCategory pyspot_category{ "Pyspot options" };
+
+static llvm::cl::opt<unsigned> jobs{ "j",
+	                                 llvm::cl::desc( "Number of translation units to process in parallel (0 = all cores)" ),
+	                                 llvm::cl::value_desc( "N" ), llvm::cl::init( 1 ),
+	                                 llvm::cl::cat( pyspot_category ) };
+
+static llvm::cl::opt<std::string> cache_dir{
+	"cache-dir", llvm::cl::desc( "Directory where to cache the bindings of unchanged translation units" ),
+	llvm::cl::value_desc( "dir" ), llvm::cl::cat( pyspot_category )
+};
+
+static llvm::cl::opt<std::string> emit_ir{
+	"emit-ir", llvm::cl::desc( "Write an IR file per translation unit into a directory instead of generating code" ),
+	llvm::cl::value_desc( "dir" ), llvm::cl::cat( pyspot_category )
+};
+
+static llvm::cl::opt<bool> ir_json{ "ir-json", llvm::cl::desc( "Write a JSON dump next to every IR file" ),
+	                                llvm::cl::cat( pyspot_category ) };
+
+static llvm::cl::opt<bool> from_ir{ "from-ir",
+	                                llvm::cl::desc( "Treat the inputs as IR files and generate code from them" ),
+	                                llvm::cl::cat( pyspot_category ) };
+
+static llvm::cl::alias merge{ "merge",
+	                          llvm::cl::desc( "Merge the partial files of --shard, given in shard order, and generate code "
+	                                          "from them (alias for --from-ir)" ),
+	                          llvm::cl::aliasopt( from_ir ), llvm::cl::cat( pyspot_category ) };
+
+static llvm::cl::opt<std::string> shard{
+	"shard",
+	llvm::cl::desc( "Process only the i-th of N contiguous parts of the sources, and write a partial file instead of "
+	                "generating code" ),
+	llvm::cl::value_desc( "i/N" ), llvm::cl::cat( pyspot_category )
+};
+
+static llvm::cl::opt<std::string> shard_output{
+	"shard-output", llvm::cl::desc( "Partial file written by --shard (default: pywrap-<i>-of-<N>.pwir)" ),
+	llvm::cl::value_desc( "file" ), llvm::cl::cat( pyspot_category )
+};
+
+static llvm::cl::opt<std::string> include_path_regex{
+	"include-path-regex", llvm::cl::desc( "Export only declarations within files whose path matches a regex" ),
+	llvm::cl::value_desc( "regex" ), llvm::cl::cat( pyspot_category )
+};
+
+static llvm::cl::opt<std::string> exclude_path_regex{
+	"exclude-path-regex", llvm::cl::desc( "Do not export declarations within files whose path matches a regex" ),
+	llvm::cl::value_desc( "regex" ), llvm::cl::cat( pyspot_category )
+};
+
+static llvm::cl::opt<bool> skip_function_bodies{
+	"skip-function-bodies",
+	llvm::cl::desc( "Parse declarations only, falling back to a full parse for translation units which need bodies" ),
+	llvm::cl::cat( pyspot_category )
+};
+
+static llvm::cl::opt<std::string> pch{
+	"pch", llvm::cl::desc( "Precompile a header included first by every translation unit, and share it across them" ),
+	llvm::cl::value_desc( "header" ), llvm::cl::cat( pyspot_category )
+};
+
+static llvm::cl::opt<bool> watch{
+	"watch",
+	llvm::cl::desc( "Keep running, and regenerate the outputs of the translation units affected by every change to "
+	                "their sources or headers" ),
+	llvm::cl::cat( pyspot_category )
+};
+
+static llvm::cl::opt<std::string> depfile{
+	"depfile", llvm::cl::desc( "Write a Make depfile listing the sources and headers the outputs depend on" ),
+	llvm::cl::value_desc( "file" ), llvm::cl::cat( pyspot_category )
+};
+
+static llvm::cl::opt<bool> depfile_all_headers{
+	"depfile-all-headers",
+	llvm::cl::desc( "List every header read in the depfile, rather than only the ones with exported declarations" ),
+	llvm::cl::cat( pyspot_category )
+};
+
+static llvm::cl::opt<bool> verbose{ "verbose",
+	                                llvm::cl::desc( "List the outputs which were already up to date and estimate the "
+	                                                "exported symbols" ),
+	                                llvm::cl::cat( pyspot_category ) };
+
+enum class ReportFormat
+{
+	None,
+	Text,
+	Json
+};
+
+static llvm::cl::opt<ReportFormat> time_report{
+	"time-report", llvm::cl::desc( "Report the time spent per phase and per translation unit" ),
+	llvm::cl::ValueOptional,
+	llvm::cl::values( clEnumValN( ReportFormat::Text, "", "Human readable report" ),
+	                  clEnumValN( ReportFormat::Json, "json", "JSON report" ) ),
+	llvm::cl::init( ReportFormat::None ), llvm::cl::cat( pyspot_category )
+};
+
+static llvm::cl::opt<ReportFormat> size_report{
+	"size-report", llvm::cl::desc( "Report the bytes and lines of code generated per module and per binding" ),
+	llvm::cl::ValueOptional,
+	llvm::cl::values( clEnumValN( ReportFormat::Text, "", "Human readable report" ),
+	                  clEnumValN( ReportFormat::Json, "json", "JSON report" ) ),
+	llvm::cl::init( ReportFormat::None ), llvm::cl::cat( pyspot_category )
+};
+
+static llvm::cl::opt<bool> size_report_time_trace{
+	"size-report-time-trace",
+	llvm::cl::desc( "Compile the generated sources with -ftime-trace, adding the time per binding to the size report" ),
+	llvm::cl::cat( pyspot_category )
+};
+
+static llvm::cl::opt<std::string> time_trace_compiler{
+	"time-trace-compiler", llvm::cl::desc( "Compiler supporting -ftime-trace, clang++ by default" ),
+	llvm::cl::value_desc( "program" ), llvm::cl::init( "clang++" ), llvm::cl::cat( pyspot_category )
+};
+
+static llvm::cl::list<std::string> time_trace_args{
+	"time-trace-arg", llvm::cl::desc( "Additional argument to compile the generated sources with, such as -I<python>" ),
+	llvm::cl::value_desc( "arg" ), llvm::cl::cat( pyspot_category )
+};
+
+static llvm::cl::opt<bool> mem_report{
+	"mem-report", llvm::cl::desc( "Report the peak memory per phase and the memory held by every kind of binding" ),
+	llvm::cl::cat( pyspot_category )
+};
+
+static llvm::cl::opt<unsigned> bindings_shards{
+	"bindings-shards", llvm::cl::desc( "Split the bindings source into N shards, assigned by the hash of the binding" ),
+	llvm::cl::value_desc( "N" ), llvm::cl::init( 1 ), llvm::cl::cat( pyspot_category )
+};
+
+static llvm::cl::opt<bool> bindings_shard_by_module{ "bindings-shard-by-module",
+	                                                 llvm::cl::desc( "Split the bindings source into a shard per module" ),
+	                                                 llvm::cl::cat( pyspot_category ) };
+
+static llvm::cl::opt<bool> hidden_symbols{
+	"hidden-symbols",
+	llvm::cl::desc( "Give hidden visibility to the generated symbols, exporting only the module init functions" ),
+	llvm::cl::cat( pyspot_category )
+};
+
+
+/// @param[in] option Option providing a regular expression
+/// @return Whether the regular expression is empty or valid, reporting the error otherwise
+static bool is_valid( const llvm::cl::opt<std::string>& option )
+{
+	std::string error;
+	if ( option.empty() || llvm::Regex{ option }.isValid( error ) )
+	{
+		return true;
+	}
+	llvm::errs() << "Invalid --" << option.ArgStr << ": " << error << '\n';
+	return false;
+}
+
+
+/// Parses the --shard option
+/// @param[out] index Index of the shard
+/// @param[out] count Number of shards
+/// @return Whether the option is valid, reporting the error otherwise
+static bool parse_shard( size_t& index, size_t& count )
+{
+	auto parts = llvm::StringRef{ shard }.split( '/' );
+	if ( parts.first.getAsInteger( 10, index ) || parts.second.getAsInteger( 10, count ) || index >= count )
+	{
+		llvm::errs() << "Invalid --shard: expected i/N with i < N, got " << shard << '\n';
+		return false;
+	}
+	return true;
+}
+
+
+/// Time report of the run, if requested
+static std::unique_ptr<pywrap::TimeReport> report;
+
+
+/// Prints the time report to the standard error, if requested
+static void print_time_report()
+{
+	if ( time_report == ReportFormat::Json )
+	{
+		report->print_json( llvm::errs() );
+	}
+	else if ( time_report == ReportFormat::Text )
+	{
+		report->print( llvm::errs() );
+	}
+}
+
+
+/// Memory report of the run, if requested
+static std::unique_ptr<pywrap::MemoryReport> memory_report;
+
+
+/// Prints the memory report to the standard error, if requested
+static void print_memory_report()
+{
+	if ( memory_report )
+	{
+		memory_report->print( llvm::errs() );
+	}
+}
+
+
+/// @param[in] compilations Compilation database of the sources
+/// @param[in] path Path of a file
+/// @return The arguments of the compile command of the file, without the compiler, the file and the output
+static std::vector<std::string> get_compile_args( const clang::tooling::CompilationDatabase& compilations,
+                                                  const std::string&                        path )
+{
+	auto commands = compilations.getCompileCommands( path );
+	if ( commands.empty() )
+	{
+		return {};
+	}
+
+	auto& command = commands.front();
+	auto  args    = clang::tooling::getClangStripOutputAdjuster()( command.CommandLine, command.Filename );
+
+	std::vector<std::string> ret;
+	for ( size_t i = 1; i < args.size(); ++i )
+	{
+		if ( args[i] != command.Filename && args[i] != "-c" )
+		{
+			ret.emplace_back( args[i] );
+		}
+	}
+	return ret;
+}
+
+
+/// Compiles the generated sources with -ftime-trace, attributing the time of every event to a binding
+/// @param[in] outputs Paths of the generated files
+/// @param[in] args Arguments to compile the generated sources with
+/// @param[out] sizes Size report to add the time traces to
+static void add_time_traces( const std::vector<std::string>& outputs, const std::vector<std::string>& args,
+                             pywrap::SizeReport& sizes )
+{
+	auto compiler = llvm::sys::findProgramByName( time_trace_compiler );
+	if ( !compiler )
+	{
+		llvm::errs() << "Could not find " << time_trace_compiler << ": " << compiler.getError().message() << '\n';
+		return;
+	}
+
+	for ( auto& output : outputs )
+	{
+		if ( llvm::sys::path::extension( output ) != ".cpp" )
+		{
+			continue;
+		}
+
+		// Clang writes the time trace next to the object file
+		llvm::SmallString<128> object;
+		if ( llvm::sys::fs::createTemporaryFile( "pywrap", "o", object ) )
+		{
+			continue;
+		}
+		llvm::SmallString<128> trace{ object };
+		llvm::sys::path::replace_extension( trace, "json" );
+
+		std::vector<std::string> command{ *compiler };
+		command.insert( command.end(), args.begin(), args.end() );
+		command.insert( command.end(), time_trace_args.begin(), time_trace_args.end() );
+		command.insert( command.end(), { "-Iinclude", "-ftime-trace", "-c", output, "-o", object.str().str() } );
+
+		std::vector<llvm::StringRef> argv{ command.begin(), command.end() };
+		std::string                  error;
+		if ( llvm::sys::ExecuteAndWait( *compiler, argv, llvm::None, {}, 0, 0, &error ) != 0 )
+		{
+			llvm::errs() << "Could not compile " << output << ( error.empty() ? "" : ": " ) << error << '\n';
+		}
+		else if ( !sizes.add_time_trace( trace.str() ) )
+		{
+			llvm::errs() << "Could not read the time trace of " << output << '\n';
+		}
+
+		llvm::sys::fs::remove( object );
+		llvm::sys::fs::remove( trace );
+	}
+}
+
+
+/// Prints the size report of the generated code to the standard error, if requested
+/// @param[in] modules Modules the code was generated for
+/// @param[in] outputs Paths of the generated files
+/// @param[in] args Arguments to compile the generated sources with
+static void print_size_report( const pywrap::ir::Modules& modules, const std::vector<std::string>& outputs,
+                               const std::vector<std::string>& args )
+{
+	if ( size_report == ReportFormat::None )
+	{
+		return;
+	}
+
+	pywrap::SizeReport sizes;
+	sizes.add_modules( modules );
+	if ( size_report_time_trace )
+	{
+		add_time_traces( outputs, args, sizes );
+	}
+
+	if ( size_report == ReportFormat::Json )
+	{
+		sizes.print_json( llvm::errs() );
+	}
+	else
+	{
+		sizes.print( llvm::errs() );
+	}
+}
+
+
+/// @param[in] path Path of a file
+/// @return The path escaped for a Make rule
+static std::string escape( std::string path )
+{
+	pywrap::replace_all( path, "$", "$$" );
+	pywrap::replace_all( path, " ", "\\ " );
+	pywrap::replace_all( path, "#", "\\#" );
+	return path;
+}
+
+
+/// Writes the depfile, if requested
+/// @param[in] targets Outputs of the run
+/// @param[in] inputs Files the outputs depend on
+/// @return False if it could not be written
+static bool write_depfile( const std::vector<std::string>& targets, const std::vector<std::string>& inputs )
+{
+	if ( depfile.empty() )
+	{
+		return true;
+	}
+
+	std::error_code      error;
+	llvm::raw_fd_ostream file{ depfile, error, llvm::sys::fs::F_Text };
+	if ( error )
+	{
+		llvm::errs() << " while opening '" << depfile << "': " << error.message() << '\n';
+		return false;
+	}
+
+	for ( size_t i = 0; i < targets.size(); ++i )
+	{
+		file << ( i > 0 ? " " : "" ) << escape( targets[i] );
+	}
+	file << ":";
+	for ( auto& input : inputs )
+	{
+		file << " \\\n  " << escape( input );
+	}
+	file << '\n';
+	return true;
+}
+
+
+/// Generates code for the modules, reporting the outputs which were already up to date
+/// @param[in] modules Modules to generate code for
+/// @return The paths of the outputs
+static std::vector<std::string> print_out( const pywrap::ir::Modules& modules )
+{
+	pywrap::Printer printer{};
+	printer.set_shards( bindings_shards );
+	printer.set_shard_by_module( bindings_shard_by_module );
+	printer.set_hidden_symbols( hidden_symbols );
+	{
+		pywrap::ScopedTime time{ report ? &report->get_phase( "print" ) : nullptr };
+		printer.print_out( modules );
+	}
+	if ( memory_report )
+	{
+		memory_report->add_phase( "print" );
+	}
+
+	if ( verbose )
+	{
+		for ( auto& output : printer.get_unchanged() )
+		{
+			llvm::outs() << "Unchanged: " << output << '\n';
+		}
+
+		auto& symbols = printer.get_symbols();
+		llvm::outs() << "Estimated exported symbols: " << symbols.exported << " of " << symbols.total << " generated\n";
+	}
+	return printer.get_outputs();
+}
+
+
+/// Watches the sources and the files they read, updating the driver and regenerating the outputs on every change
+/// @param[in] driver Driver of the last run
+/// @return EXIT_FAILURE when files can no longer be watched
+static int watch_changes( pywrap::Driver& driver )
+{
+	pywrap::Watcher watcher;
+	while ( true )
+	{
+		// The files read by the sources change along with their includes, so they are collected after every update
+		std::vector<std::string> files;
+		for ( auto& source : driver.get_sources() )
+		{
+			llvm::SmallString<256> path{ source };
+			llvm::sys::fs::make_absolute( path );
+			files.emplace_back( path.str() );
+		}
+		for ( auto& dependencies : driver.get_dependencies() )
+		{
+			files.insert( files.end(), dependencies.begin(), dependencies.end() );
+		}
+		std::sort( files.begin(), files.end() );
+		files.erase( std::unique( files.begin(), files.end() ), files.end() );
+
+		if ( !watcher.watch( files ) )
+		{
+			return EXIT_FAILURE;
+		}
+		llvm::outs() << "Watching " << files.size() << " files\n";
+		llvm::outs().flush();
+
+		auto changed = watcher.wait();
+		if ( changed.empty() )
+		{
+			return EXIT_FAILURE;
+		}
+
+		auto start  = pywrap::Time::now();
+		auto result = driver.update( changed );
+		auto units  = driver.get_stats().extracted_units;
+		if ( units == 0 )
+		{
+			continue;
+		}
+
+		if ( result != EXIT_SUCCESS )
+		{
+			// Outputs are kept as they are until the error is fixed
+			llvm::errs() << "Could not extract every translation unit, outputs are not updated\n";
+			continue;
+		}
+		if ( emit_ir.empty() && !write_depfile( print_out( driver.get_modules() ),
+		                                        driver.get_inputs( depfile_all_headers ) ) )
+		{
+			return EXIT_FAILURE;
+		}
+		llvm::outs() << llvm::format( "Extracted %zu of %zu translation units again in %.3f s\n", units,
+		                              driver.get_sources().size(), ( pywrap::Time::now() - start ).wall );
+	}
+}
+
+
+/// Generates code from IR files, merging them in order
+/// @param[in] compilations Compilation database, providing the arguments to compile the generated sources with
+/// @param[in] paths IR files to read
+/// @return EXIT_SUCCESS on success
+static int emit( const clang::tooling::CompilationDatabase& compilations, const std::vector<std::string>& paths )
+{
+	pywrap::ir::Modules      modules;
+	std::vector<std::string> inputs;
+	{
+		pywrap::ScopedTime time{ report ? &report->get_phase( "read" ) : nullptr };
+		for ( auto& path : paths )
+		{
+			if ( !pywrap::ir::read_file( path, modules ) )
+			{
+				return EXIT_FAILURE;
+			}
+
+			llvm::SmallString<256> input{ path };
+			llvm::sys::fs::make_absolute( input );
+			inputs.emplace_back( input.str() );
+		}
+		pywrap::ir::sort( modules );
+	}
+	if ( memory_report )
+	{
+		memory_report->add_phase( "read" );
+		memory_report->add_modules( modules );
+	}
+
+	auto outputs = print_out( modules );
+	if ( !paths.empty() )
+	{
+		print_size_report( modules, outputs, get_compile_args( compilations, paths.front() ) );
+	}
+	print_time_report();
+	print_memory_report();
+	return write_depfile( outputs, inputs ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/// @param[in] args Command line arguments
+/// @return Whether the arguments ask to generate code from IR files without the -- separator
+static bool needs_separator( const std::vector<const char*>& args )
+{
+	bool reads_ir = false;
+	for ( llvm::StringRef arg : args )
+	{
+		if ( arg == "--" )
+		{
+			return false;
+		}
+
+		arg = arg.ltrim( '-' );
+		for ( auto name : { "from-ir", "merge" } )
+		{
+			if ( arg == name || arg == std::string{ name } + "=true" || arg == std::string{ name } + "=1" )
+			{
+				reads_ir = true;
+			}
+		}
+	}
+	return reads_ir;
+}
 
 
 int main( int argc, const char** argv )
 {
+	// IR files need no compile commands, so a missing separator does not look for a compilation database
+	std::vector<const char*> args{ argv, argv + argc };
+	if ( needs_separator( args ) )
+	{
+		args.emplace_back( "--" );
+	}
+	int arg_count = static_cast<int>( args.size() );
+
 	// Parse the command-line args passed to your code
-	llvm::cl::OptionCategory            pyspot_category{ "Pyspot options" };
-	clang::tooling::CommonOptionsParser op{ argc, argv, pyspot_category };
+	clang::tooling::CommonOptionsParser op{ arg_count, args.data(), pyspot_category };
+
+	if ( time_report != ReportFormat::None )
+	{
+		report.reset( new pywrap::TimeReport{} );
+	}
+	if ( mem_report )
+	{
+		memory_report.reset( new pywrap::MemoryReport{} );
+	}
 
-	// Create a new Clang Tool instance (a LibTooling environment)
-	clang::tooling::ClangTool tool{ op.getCompilations(), op.getSourcePathList() };
+	if ( from_ir )
+	{
+		return emit( op.getCompilations(), op.getSourcePathList() );
+	}
 
-	// Run the Clang Tool, creating a new FrontendAction
-	pywrap::FrontendActionFactory factory{};
-	auto                          result = tool.run( &factory );
-	if ( result == EXIT_SUCCESS )
+	if ( !is_valid( include_path_regex ) || !is_valid( exclude_path_regex ) )
+	{
+		return EXIT_FAILURE;
+	}
+
+	if ( !depfile.empty() && !emit_ir.empty() )
+	{
+		llvm::errs() << "--depfile can not be used along with --emit-ir\n";
+		return EXIT_FAILURE;
+	}
+
+	if ( watch && ( !shard.empty() || !pywrap::Watcher::is_supported() ) )
+	{
+		llvm::errs() << ( shard.empty() ? "--watch is only supported on Linux\n"
+		                                : "--watch can not be used along with --shard\n" );
+		return EXIT_FAILURE;
+	}
+
+	auto   sources     = op.getSourcePathList();
+	size_t shard_index = 0;
+	size_t shard_count = 1;
+	if ( !shard.empty() )
+	{
+		if ( !parse_shard( shard_index, shard_count ) )
+		{
+			return EXIT_FAILURE;
+		}
+		// Parts are contiguous, so merging the partial files in shard order follows the order of the sources
+		auto begin = sources.size() * shard_index / shard_count;
+		auto end   = sources.size() * ( shard_index + 1 ) / shard_count;
+		sources    = std::vector<std::string>( sources.begin() + begin, sources.begin() + end );
+	}
+
+	// Run the frontend action over every source, using a worker per job
+	pywrap::Driver driver{ op.getCompilations(), jobs };
+	driver.set_path_filter( include_path_regex, exclude_path_regex );
+	driver.set_skip_function_bodies( skip_function_bodies );
+	driver.set_pch( pch );
+	driver.set_time_report( report.get() );
+	driver.set_memory_report( memory_report.get() );
+	driver.set_incremental( watch );
+	driver.set_track_dependencies( !depfile.empty() );
+	if ( !cache_dir.empty() )
+	{
+		driver.set_cache( cache_dir );
+	}
+	if ( !emit_ir.empty() )
+	{
+		driver.set_ir_output( emit_ir, ir_json );
+	}
+
+	auto result = driver.run( sources );
+
+	auto& stats = driver.get_stats();
+	if ( stats.skipped_decls > 0 )
+	{
+		llvm::outs() << "Skipped already extracted: " << stats.skipped_decls << " declarations\n";
+	}
+	if ( result == EXIT_SUCCESS && !shard.empty() )
+	{
+		// Every shard is written, even if empty, so merging does not depend on the number of sources
+		auto output = shard_output.empty()
+		                  ? "pywrap-" + std::to_string( shard_index ) + "-of-" + std::to_string( shard_count ) + ".pwir"
+		                  : shard_output.getValue();
+		if ( !pywrap::ir::write_file( output, driver.get_modules() ) ||
+		     !write_depfile( { output }, driver.get_inputs( depfile_all_headers ) ) )
+		{
+			result = EXIT_FAILURE;
+		}
+	}
+	else if ( result == EXIT_SUCCESS && emit_ir.empty() )
 	{
 		// This is going to write code for us
-		pywrap::Printer printer{};
-		printer.print_out( factory.get_modules() );
+		auto outputs = print_out( driver.get_modules() );
+		print_size_report( driver.get_modules(), outputs, get_compile_args( op.getCompilations(), sources.front() ) );
+		if ( !write_depfile( outputs, driver.get_inputs( depfile_all_headers ) ) )
+		{
+			result = EXIT_FAILURE;
+		}
 	}
 
+	print_time_report();
+	print_memory_report();
+
+	if ( watch )
+	{
+		// Translation units which failed are extracted again once any of their files changes
+		return watch_changes( driver );
+	}
 	return result;
 }
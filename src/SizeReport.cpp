@@ -0,0 +1,325 @@
+#include "pywrap/SizeReport.h"
+
+#include <algorithm>
+#include <cctype>
+
+#include <llvm/Support/Format.h>
+#include <llvm/Support/FormatVariadic.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include "pywrap/Printer.h"
+#include "pywrap/Util.h"
+
+
+namespace pywrap
+{
+/// @param[in] code Generated code
+/// @param[in,out] size Size to add the bytes and lines of the code to
+static void add_code( const std::string& code, CodeSize& size )
+{
+	size.bytes += code.size();
+	size.lines += std::count( code.begin(), code.end(), '\n' );
+}
+
+
+void SizeReport::add_modules( const ir::Modules& modules )
+{
+	for ( auto& pr : modules )
+	{
+		add_module( pr.second );
+	}
+}
+
+
+void SizeReport::add_symbol( const std::string& prefix, const size_t index )
+{
+	// Overloads share their symbols, which are attributed to the first one
+	symbols.emplace( prefix, index );
+}
+
+
+void SizeReport::add_module( const ir::Module& module, const ir::Module* parent )
+{
+	for ( auto& child : module.modules )
+	{
+		add_module( child, &module );
+	}
+
+	CodeSize size;
+	size.id   = module.id;
+	size.kind = "module";
+	for ( auto code : { &module.decl, &module.def, &module.methods } )
+	{
+		add_code( *code, size );
+	}
+	if ( parent )
+	{
+		std::string              reg;
+		llvm::raw_string_ostream os{ reg };
+		Printer::print_module_reg( os, *parent, module );
+		add_code( os.str(), size );
+	}
+
+	auto index = sizes.size();
+	sizes.emplace_back( std::move( size ) );
+	add_symbol( module.py_name, index );
+
+	for ( auto bindings : { &module.functions, &module.enums, &module.templates, &module.specializations,
+	                        &module.records, &module.converters } )
+	{
+		for ( auto& binding : *bindings )
+		{
+			// Symbols are named after the Python name of the declaration, while converters are named on their own
+			auto symbol = binding.kind == ir::Kind::Converter ? binding.id : to_pyspot_name( binding.id );
+			add_binding( module, binding, symbol );
+
+			// Accessors are named after their record
+			for ( auto& field : binding.fields )
+			{
+				auto field_index = add_binding( module, field, symbol + "_get_" + field.name );
+				add_symbol( symbol + "_set_" + field.name, field_index );
+			}
+		}
+	}
+
+	// A module accounts for its own code and the code of its bindings, which follow it
+	auto& total = sizes[index];
+	for ( auto i = index + 1; i < sizes.size(); ++i )
+	{
+		total.bytes += sizes[i].bytes;
+		total.lines += sizes[i].lines;
+	}
+}
+
+
+size_t SizeReport::add_binding( const ir::Module& module, const ir::Binding& binding, const std::string& symbol )
+{
+	CodeSize size;
+	size.id     = binding.id;
+	size.kind   = ir::to_string( binding.kind );
+	size.module = module.id;
+	for ( auto code : { &binding.decl, &binding.def } )
+	{
+		add_code( *code, size );
+	}
+
+	// The printer renders the rest of the code of a binding from its declaration
+	std::string              printed;
+	llvm::raw_string_ostream os{ printed };
+	switch ( binding.kind )
+	{
+		case ir::Kind::Function:
+			Printer::print_method( os, binding );
+			break;
+		case ir::Kind::Enum:
+		case ir::Kind::Specialization:
+		case ir::Kind::Record:
+			Printer::print_wrapper_decl( os, binding );
+			Printer::print_reg( os, module, binding );
+			break;
+		case ir::Kind::Template:
+			Printer::print_reg( os, module, binding );
+			break;
+		default:
+			break;
+	}
+	add_code( os.str(), size );
+	for ( auto& item : binding.items )
+	{
+		add_code( item.def, size );
+	}
+
+	auto index = sizes.size();
+	sizes.emplace_back( std::move( size ) );
+	add_symbol( symbol, index );
+	return index;
+}
+
+
+CodeSize* SizeReport::find_entry( llvm::StringRef detail )
+{
+	CodeSize* ret    = nullptr;
+	size_t    longest = 0;
+
+	// Details are names of functions, classes or files, made of identifiers and qualified names
+	auto is_name = []( const char c ) { return std::isalnum( static_cast<unsigned char>( c ) ) || c == '_' || c == ':'; };
+	while ( !detail.empty() )
+	{
+		auto token = detail.take_while( is_name );
+		detail     = detail.drop_front( token.size() ).drop_while( [&is_name]( const char c ) { return !is_name( c ); } );
+		if ( token.empty() )
+		{
+			continue;
+		}
+
+		// Generated symbols are looked up as they are, C++ names by their Python name
+		auto name = token.startswith( "py_" ) || token.startswith( "pyspot_" ) ? token.str() : to_pyspot_name( token.str() );
+
+		// The longest prefix ending before an underscore wins, so an accessor wins over its record
+		for ( auto end = name.size(); end > longest && end != std::string::npos; end = name.rfind( '_', end - 1 ) )
+		{
+			auto it = symbols.find( name.substr( 0, end ) );
+			if ( it != symbols.end() )
+			{
+				ret     = &sizes[it->second];
+				longest = end;
+				break;
+			}
+		}
+	}
+
+	return ret;
+}
+
+
+bool SizeReport::add_time_trace( const std::string& path )
+{
+	auto buffer = llvm::MemoryBuffer::getFile( path );
+	if ( !buffer )
+	{
+		return false;
+	}
+
+	auto json = llvm::json::parse( ( *buffer )->getBuffer() );
+	if ( !json )
+	{
+		llvm::consumeError( json.takeError() );
+		return false;
+	}
+
+	auto root   = json->getAsObject();
+	auto events = root ? root->getArray( "traceEvents" ) : nullptr;
+	if ( !events )
+	{
+		return false;
+	}
+
+	for ( auto& value : *events )
+	{
+		auto event = value.getAsObject();
+		if ( !event )
+		{
+			continue;
+		}
+
+		auto name     = event->getString( "name" );
+		auto duration = event->getNumber( "dur" );
+		auto args     = event->getObject( "args" );
+		auto detail   = args ? args->getString( "detail" ) : llvm::None;
+
+		// Totals summarize the other events
+		if ( !name || !duration || !detail || name->startswith( "Total " ) )
+		{
+			continue;
+		}
+
+		if ( auto entry = find_entry( *detail ) )
+		{
+			auto seconds = *duration / 1e6;
+			if ( name->startswith( "CodeGen" ) || name->startswith( "Opt" ) || name->startswith( "RunPass" ) )
+			{
+				entry->backend += seconds;
+			}
+			else
+			{
+				entry->frontend += seconds;
+			}
+		}
+	}
+
+	++traces;
+	return true;
+}
+
+
+template <typename Key>
+std::vector<const CodeSize*> SizeReport::get_largest( const size_t count, Key key ) const
+{
+	std::vector<const CodeSize*> ret;
+	for ( auto& size : sizes )
+	{
+		if ( size.kind != "module" )
+		{
+			ret.emplace_back( &size );
+		}
+	}
+
+	auto middle = ret.begin() + std::min( count, ret.size() );
+	std::partial_sort( ret.begin(), middle, ret.end(), [&key]( const CodeSize* a, const CodeSize* b ) {
+		return key( *a ) > key( *b ) || ( key( *a ) == key( *b ) && a->id < b->id );
+	} );
+	ret.erase( middle, ret.end() );
+	return ret;
+}
+
+
+void SizeReport::print( llvm::raw_ostream& os ) const
+{
+	os << "===-------------------------------------------------------------------------===\n"
+	   << "                             Pywrap size report\n"
+	   << "===-------------------------------------------------------------------------===\n\n";
+
+	os << "        Bytes         Lines  Module\n";
+	for ( auto& size : sizes )
+	{
+		if ( size.kind == "module" )
+		{
+			os << llvm::format( "%13zu  %12zu  ", size.bytes, size.lines ) << size.id << '\n';
+		}
+	}
+
+	os << "\n        Bytes         Lines  Largest bindings\n";
+	for ( auto size : get_largest( largest_count, []( const CodeSize& s ) { return s.bytes; } ) )
+	{
+		os << llvm::format( "%13zu  %12zu  ", size->bytes, size->lines ) << size->kind << ' ' << size->id << '\n';
+	}
+
+	if ( traces == 0 )
+	{
+		return;
+	}
+
+	os << "\n Frontend (s)   Backend (s)  Slowest bindings to compile, over " << traces << " time traces\n";
+	for ( auto size :
+	      get_largest( largest_count, []( const CodeSize& s ) { return s.frontend + s.backend; } ) )
+	{
+		os << llvm::format( "%13.3f  %12.3f  ", size->frontend, size->backend ) << size->kind << ' ' << size->id
+		   << '\n';
+	}
+}
+
+
+void SizeReport::print_json( llvm::raw_ostream& os ) const
+{
+	llvm::json::Array modules;
+	llvm::json::Array bindings;
+	for ( auto& size : sizes )
+	{
+		llvm::json::Object entry{ { "id", size.id },
+			                      { "bytes", static_cast<int64_t>( size.bytes ) },
+			                      { "lines", static_cast<int64_t>( size.lines ) } };
+		if ( traces > 0 )
+		{
+			entry["frontend"] = size.frontend;
+			entry["backend"]  = size.backend;
+		}
+
+		if ( size.kind == "module" )
+		{
+			modules.push_back( std::move( entry ) );
+		}
+		else
+		{
+			entry["kind"]   = size.kind;
+			entry["module"] = size.module;
+			bindings.push_back( std::move( entry ) );
+		}
+	}
+
+	llvm::json::Object root{ { "modules", std::move( modules ) }, { "bindings", std::move( bindings ) } };
+	os << llvm::formatv( "{0:2}", llvm::json::Value{ std::move( root ) } ) << '\n';
+}
+
+
+}  // namespace pywrap
@@ -1,4 +1,7 @@
 #include "pywrap/Util.h"
+
+#include <llvm/Support/MD5.h>
+
 #include "pywrap/binding/CXXRecord.h"
 
 namespace pywrap
@@ -23,6 +26,17 @@ std::string replace_all( const std::string& str, const llvm::StringRef& from, co
 }
 
 
+std::string get_path( const clang::FileEntry& entry )
+{
+	auto path = entry.tryGetRealPathName();
+	if ( path.empty() )
+	{
+		path = entry.getName();
+	}
+	return replace_all( path.str(), "\\", "/" );
+}
+
+
 /// @param[in] name A c++ qualified name
 /// @return A new string replacing every invalid character with a _ and putting a py_ at the beginning
 std::string to_pyspot_name( std::string name )
@@ -119,7 +133,106 @@ clang::QualType to_type( const clang::QualType& type, const TemplateMap& tMap )
 	return tempType;
 }
 
-std::string to_python( const clang::QualType& qual_type, std::string name )
+/// @param[in] type A type
+/// @param[in] ctx Context of the translation unit of the type
+/// @return The spelling of the canonical type, valid within any scope
+static std::string get_canonical_name( const clang::QualType& type, const clang::ASTContext& ctx )
+{
+	auto policy               = ctx.getPrintingPolicy();
+	policy.SuppressTagKeyword = true;
+	return type.getAsString( policy );
+}
+
+
+/// @param[in] prefix Prefix telling the direction of the conversion
+/// @param[in] type Spelling of the canonical type
+/// @return The name of a helper, the same for the same type across translation units
+static std::string get_converter_name( const std::string& prefix, const std::string& type )
+{
+	llvm::MD5 hash;
+	hash.update( type );
+	llvm::MD5::MD5Result digest;
+	hash.final( digest );
+	return prefix + digest.digest().substr( 0, 16 ).str();
+}
+
+
+const std::string& Converters::to_python( const clang::QualType& type )
+{
+	auto canonical = type.getCanonicalType().getUnqualifiedType();
+	auto it        = python_names.find( canonical.getTypePtr() );
+	if ( it != python_names.end() )
+	{
+		return it->second;
+	}
+
+	auto  spec = clang::cast<clang::ClassTemplateSpecializationDecl>( canonical->getAsCXXRecordDecl() );
+	auto& args = spec->getTemplateArgs();
+
+	Converter converter;
+	converter.type = get_canonical_name( canonical, spec->getASTContext() );
+	converter.name = get_converter_name( "pyspot_to_python_", converter.type );
+	converter.decl = "PyObject* " + converter.name + "( const " + converter.type + "& value );\n";
+
+	// Helpers of the contained types come first
+	std::string def = "// " + converter.type + "\nPyObject* " + converter.name + "( const " + converter.type +
+	                  "& value )\n{\n";
+	if ( spec->getName() == "map" )
+	{
+		def += "\tauto ret = PyDict_New();\n\tfor ( auto& pair : value )\n\t{\n";
+		def += "\t\tauto py_key = " + pywrap::to_python( args.get( 0 ).getAsType(), "pair.first", *this ) + ";\n";
+		def += "\t\tauto py_val = " + pywrap::to_python( args.get( 1 ).getAsType(), "pair.second", *this ) + ";\n";
+		def += "\t\tPyDict_SetItem( ret, py_key, py_val );\n\t}\n";
+	}
+	else
+	{
+		def += "\tauto ret = PyList_New( value.size() );\n\tfor ( size_t i = 0; i < value.size(); ++i )\n\t{\n";
+		def += "\t\tauto& element = value[i];\n";
+		def += "\t\tauto py_element = " + pywrap::to_python( args.get( 0 ).getAsType(), "element", *this ) + ";\n";
+		def += "\t\tPyList_SET_ITEM( ret, i, py_element );\n\t}\n";
+	}
+	converter.def = def + "\treturn ret;\n}\n\n";
+
+	converters.emplace_back( std::move( converter ) );
+	return python_names[canonical.getTypePtr()] = converters.back().name;
+}
+
+
+const std::string& Converters::to_c( const clang::QualType& type )
+{
+	auto canonical = type.getCanonicalType().getUnqualifiedType();
+	auto it        = c_names.find( canonical.getTypePtr() );
+	if ( it != c_names.end() )
+	{
+		return it->second;
+	}
+
+	auto  spec = clang::cast<clang::ClassTemplateSpecializationDecl>( canonical->getAsCXXRecordDecl() );
+	auto& args = spec->getTemplateArgs();
+
+	Converter converter;
+	converter.type = get_canonical_name( canonical, spec->getASTContext() );
+	converter.name = get_converter_name( "pyspot_to_c_", converter.type );
+	converter.decl = converter.type + " " + converter.name + "( PyObject* value );\n";
+
+	// The map is returned by value, so the same helper initializes constructor arguments and assigns fields.
+	// Assigning replaces the comparator and allocator of the field as well, where filling it kept them
+
+	// Get elements from python dict
+	std::string def = "// " + converter.type + "\n" + converter.type + " " + converter.name + "( PyObject* value )\n{\n";
+	def += "\t" + converter.type + " ret;\n\tPyObject* py_key;\n\tPyObject* py_val;\n\tPy_ssize_t pos = 0;\n";
+	def += "\twhile ( PyDict_Next( value, &pos, &py_key, &py_val ) )\n\t{\n";
+	def += "\t\tauto " + pywrap::to_c( args.get( 0 ).getAsType(), "py_key", "key", *this ) + ";\n";
+	def += "\t\tauto " + pywrap::to_c( args.get( 1 ).getAsType(), "py_val", "val", *this ) + ";\n";
+	def += "\t\tret[key] = val;\n\t}\n";
+	converter.def = def + "\treturn ret;\n}\n\n";
+
+	converters.emplace_back( std::move( converter ) );
+	return c_names[canonical.getTypePtr()] = converters.back().name;
+}
+
+
+std::string to_python( const clang::QualType& qual_type, std::string name, Converters& converters )
 {
 	auto type = qual_type;
 
@@ -168,7 +281,7 @@ std::string to_python( const clang::QualType& qual_type, std::string name )
 		auto array = type->getAsArrayTypeUnsafe();
 		auto contained_type = array->getElementType();
 
-		ret += to_python( contained_type , "element" );
+		ret += to_python( contained_type, "element", converters );
 
 		ret += ";\n\t\tPyList_SET_ITEM( ret, i, py_element );\n\t}";
 		return ret;
@@ -178,38 +291,10 @@ std::string to_python( const clang::QualType& qual_type, std::string name )
 	{
 		return "PyUnicode_FromString( " + name + ".c_str() )";
 	}
-	// Vector
-	else if ( type_name.find( "std::vector" ) == 0 )
+	// Vector and map, converted by a helper shared by every use of the type
+	else if ( type_name.find( "std::vector" ) == 0 || type_name.find( "std::map" ) == 0 )
 	{
-		// Create python list
-		std::string ret = "PyList_New( " + name + ".size() );\n";
-		ret += "\tfor ( size_t i = 0; i < " + name + ".size(); ++i )\n\t{\n" + "\t\tauto& element = " + name + "[i];\n" +
-		       "\t\tauto py_element = ";  // get param time
-		auto  vec_class      = qual_type->getAsCXXRecordDecl();
-		auto  spec           = clang::dyn_cast<clang::ClassTemplateSpecializationDecl>( vec_class );
-		auto contained_type = spec->getTemplateArgs().get( 0 ).getAsType();
-
-		ret += to_python( contained_type, "element" );
-
-		ret += ";\n\t\tPyList_SET_ITEM( ret, i, py_element );\n\t}\n";
-		return ret;
-	}
-	// Map
-	else if ( type_name.find( "std::map" ) == 0 )
-	{
-		std::string ret = "PyDict_New();\n";
-		ret += "\tfor ( auto& pair : " + name + " )\n\t{\n";
-
-		auto  map_class      = qual_type->getAsCXXRecordDecl();
-		auto  spec           = clang::dyn_cast<clang::ClassTemplateSpecializationDecl>( map_class );
-		auto key_type = spec->getTemplateArgs().get( 0 ).getAsType();
-		auto val_type = spec->getTemplateArgs().get( 1 ).getAsType();
-
-		ret += "\t\tauto py_key = " + to_python( key_type, "pair.first" ) + ";\n";
-		ret += "\t\tauto py_val = " + to_python( val_type, "pair.second" ) + ";\n";
-		ret += "\t\tPyDict_SetItem( ret, py_key, py_val );\n\t}\n";
-
-		return ret;
+		return converters.to_python( type ) + "( " + name + " )";
 	}
 	// Object
 	else
@@ -219,7 +304,7 @@ std::string to_python( const clang::QualType& qual_type, std::string name )
 }
 
 
-std::string to_c( const clang::QualType& type, std::string name, std::string dest )
+std::string to_c( const clang::QualType& type, std::string name, std::string dest, Converters& converters )
 {
 	auto actual_type = type;
 
@@ -280,7 +365,7 @@ std::string to_c( const clang::QualType& type, std::string name, std::string des
 		ret += "\tfor( size_t i = 0; i < array_size; ++i )\n\t{\n";
 		ret += "\t\tauto element = PyList_GetItem( " + name + ", i );\n";
 		auto array = type->getAsArrayTypeUnsafe();
-		ret += "\t\t" + to_c( array->getElementType(), "element", dest + "[i]" ) + ";\n";
+		ret += "\t\t" + to_c( array->getElementType(), "element", dest + "[i]", converters ) + ";\n";
 		ret += "\t}\n";
 	}
 	// String
@@ -298,22 +383,10 @@ std::string to_c( const clang::QualType& type, std::string name, std::string des
 		// TODO fill vector
 		ret += "std::vector<" + contained_type.getAsType().getAsString() + ">{}";
 	}
-	// Map
+	// Map, converted by a helper shared by every use of the type
 	else if ( type_name.find( "std::map" ) == 0 )
 	{
-		// Create python dictionary
-		auto  map_class      = actual_type->getAsCXXRecordDecl();
-		auto  spec           = clang::dyn_cast<clang::ClassTemplateSpecializationDecl>( map_class );
-		auto key_type = spec->getTemplateArgs().get( 0 ).getAsType();
-		auto val_type = spec->getTemplateArgs().get( 1 ).getAsType();
-
-		// Get elements from python dict
-		ret = dest + ".clear();\n\tPyObject* py_key;\n\tPyObject* py_val;\n\tPy_ssize_t pos = 0;\n";
-		ret += "\twhile ( PyDict_Next( " + name + ", &pos, &py_key, &py_val ) )\n\t{\n";
-		ret += "\t\tauto " + to_c( key_type, "py_key", "key" ) + ";\n";
-		ret += "\t\tauto " + to_c( val_type, "py_val", "val" ) + ";\n";
-		ret += "\t\t" + dest + "[key] = val;\n";
-		ret += "\t}\n";
+		ret += converters.to_c( actual_type ) + "( " + name + " )";
 	}
 	// Object
 	else
@@ -0,0 +1,182 @@
+#include "pywrap/Watcher.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+#ifdef __linux__
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+
+namespace pywrap
+{
+#ifdef __linux__
+/// Time without events after which changes are considered settled, in milliseconds
+static const int settle_time = 100;
+
+
+Watcher::Watcher() : fd{ inotify_init1( IN_CLOEXEC ) }
+{
+}
+
+
+Watcher::~Watcher()
+{
+	if ( fd >= 0 )
+	{
+		close( fd );
+	}
+}
+
+
+bool Watcher::is_supported()
+{
+	return true;
+}
+
+
+bool Watcher::watch( const std::vector<std::string>& paths )
+{
+	if ( fd < 0 )
+	{
+		llvm::errs() << "Could not initialize inotify\n";
+		return false;
+	}
+
+	files = std::unordered_set<std::string>{ paths.begin(), paths.end() };
+
+	// Watches are kept across calls, so events queued meanwhile still match their directory.
+	// Adding a directory which is already watched returns its current descriptor
+	std::unordered_map<int, std::string> watched;
+	for ( auto& path : paths )
+	{
+		auto dir = llvm::sys::path::parent_path( path ).str();
+		auto wd  = inotify_add_watch( fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE );
+		if ( wd < 0 )
+		{
+			llvm::errs() << "Could not watch " << dir << '\n';
+			return false;
+		}
+		watched.emplace( wd, dir );
+	}
+
+	for ( auto& dir : dirs )
+	{
+		if ( !watched.count( dir.first ) )
+		{
+			inotify_rm_watch( fd, dir.first );
+		}
+	}
+	dirs = std::move( watched );
+	return true;
+}
+
+
+std::vector<std::string> Watcher::wait()
+{
+	std::unordered_set<std::string> changed;
+
+	// Writes come in bursts, so events are collected until none arrives for a while
+	auto timeout = -1;
+	while ( true )
+	{
+		pollfd events{ fd, POLLIN, 0 };
+		auto   ready = poll( &events, 1, timeout );
+		if ( ready < 0 )
+		{
+			if ( errno == EINTR )
+			{
+				continue;
+			}
+			return {};
+		}
+		if ( ready == 0 )
+		{
+			if ( changed.empty() )
+			{
+				timeout = -1;
+				continue;
+			}
+			break;
+		}
+
+		alignas( inotify_event ) char buffer[4096];
+		auto                          size = read( fd, buffer, sizeof( buffer ) );
+		if ( size < 0 && errno == EINTR )
+		{
+			continue;
+		}
+		if ( size <= 0 )
+		{
+			return {};
+		}
+
+		for ( auto it = buffer; it < buffer + size; )
+		{
+			auto event = reinterpret_cast<const inotify_event*>( it );
+			it += sizeof( inotify_event ) + event->len;
+
+			auto dir = dirs.find( event->wd );
+			if ( dir == dirs.end() || event->len == 0 )
+			{
+				continue;
+			}
+
+			llvm::SmallString<256> path{ dir->second };
+			llvm::sys::path::append( path, event->name );
+			if ( files.count( path.str() ) )
+			{
+				changed.emplace( path.str() );
+			}
+		}
+		timeout = settle_time;
+	}
+
+	std::vector<std::string> result{ changed.begin(), changed.end() };
+	std::sort( result.begin(), result.end() );
+	return result;
+}
+
+
+#else
+
+
+Watcher::Watcher()
+{
+}
+
+
+Watcher::~Watcher()
+{
+}
+
+
+bool Watcher::is_supported()
+{
+	return false;
+}
+
+
+bool Watcher::watch( const std::vector<std::string>& )
+{
+	llvm::errs() << "Watching files is only supported on Linux\n";
+	return false;
+}
+
+
+std::vector<std::string> Watcher::wait()
+{
+	return {};
+}
+
+
+#endif
+
+
+}  // namespace pywrap
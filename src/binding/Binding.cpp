@@ -13,14 +13,30 @@ Binding::Binding( const clang::NamedDecl* n, const Binding* p )
 }
 
 
+std::string Binding::get_decl() const
+{
+	std::string              ret;
+	llvm::raw_string_ostream os{ ret };
+	print_decl( os );
+	return os.str();
+}
+
+
+std::string Binding::get_def() const
+{
+	std::string              ret;
+	llvm::raw_string_ostream os{ ret };
+	print_def( os );
+	return os.str();
+}
+
+
 void Binding::init()
 {
 	gen_name();
 	gen_qualified_name();
 	gen_py_name();
 	gen_sign();
-	gen_decl();
-	gen_def();
 }
 
 
@@ -50,7 +66,7 @@ void Binding::gen_py_name()
 }
 
 
-void Binding::gen_decl()
+void Binding::gen_decl( llvm::raw_ostream& decl ) const
 {
 	decl << sign.str() << ";\n\n";
 }
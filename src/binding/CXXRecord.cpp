@@ -9,6 +9,16 @@ CXXRecord::CXXRecord( const clang::CXXRecordDecl& rec, const Binding& parent ) :
 }
 
 
+CXXRecord::CXXRecord( CXXRecord&& o ) : Tag{ std::move( o ) }, record{ o.record }, fields{ std::move( o.fields ) }
+{
+	// Fields refer to their tag while their accessors are printed
+	for ( auto& field : fields )
+	{
+		field.tag = this;
+	}
+}
+
+
 void CXXRecord::gen_fields()
 {
 	for ( auto field : record.fields() )
@@ -53,29 +63,27 @@ void CXXRecord::init()
 }
 
 
-std::string CXXRecord::get_decl() const
+void CXXRecord::print_decl( llvm::raw_ostream& os ) const
 {
-	std::string ret;
-
 	for ( auto& field : fields )
 	{
-		ret += field.get_getter().get_decl() + field.get_setter().get_decl();
+		field.get_getter().print_decl( os );
+		field.get_setter().print_decl( os );
 	}
 
-	return ret + Tag::get_decl();
+	Tag::print_decl( os );
 }
 
 
-std::string CXXRecord::get_def() const
+void CXXRecord::print_def( llvm::raw_ostream& os ) const
 {
-	std::string ret;
-
 	for ( auto& field : fields )
 	{
-		ret += field.get_getter().get_def() + field.get_setter().get_def();
+		field.get_getter().print_def( os );
+		field.get_setter().print_def( os );
 	}
 
-	return ret + Tag::get_def();
+	Tag::print_def( os );
 }
 
 
@@ -149,7 +157,7 @@ const clang::TemplateArgument* Specialization::get_arg( const clang::FieldDecl&
 }
 
 
-Template::Template( const clang::ClassTemplateDecl& t, const Binding& parent ) : Tag{ t, parent }, templ{ t }
+Template::Template( const clang::ClassTemplateDecl& t, const Binding& parent ) : Tag{ t, parent }
 {
 }
 
@@ -157,7 +165,6 @@ Template::Template( const clang::ClassTemplateDecl& t, const Binding& parent ) :
 void Template::add( const Specialization& spec )
 {
 	get_mut_class_getitem().add( spec );
-	specializations.push_back( &spec );
 }
 
 
@@ -27,7 +27,7 @@ void ClassGetitem::gen_sign()
 }
 
 
-void ClassGetitem::gen_def()
+void ClassGetitem::gen_def( llvm::raw_ostream& def ) const
 {
 	if ( tag )
 	{
@@ -42,20 +42,42 @@ void ClassGetitem::add( const Specialization& spec )
 	auto& args = spec.get_args();
 	assert( args.size() == 1 && "Multiple template arguments not supported yet" );
 	auto& arg = args[0];
-	def << "\tif ( item_type->tp_name == \"" << arg.getAsType().getAsString() << "\"s )\n\t{\n"
-	    << "\t\tPy_INCREF( &" << spec.get_type_object().get_py_name() << " );\n"
-	    << "\t\treturn reinterpret_cast<PyObject*>( &" << spec.get_type_object().get_py_name() << " );\n"
-	    << "\t}\n\n";
+
+	items.push_back( { spec.get_qualified_name(), arg.getAsType().getAsString(), spec.get_type_object().get_py_name() } );
 }
 
-std::string ClassGetitem::get_def() const
+void ClassGetitem::print_item( llvm::raw_ostream& os, const Item& item )
 {
-	if ( !tag )
+	os << "\tif ( item_type->tp_name == \"" << item.arg << "\"s )\n\t{\n"
+	   << "\t\tPy_INCREF( &" << item.type_object << " );\n"
+	   << "\t\treturn reinterpret_cast<PyObject*>( &" << item.type_object << " );\n"
+	   << "\t}\n\n";
+}
+
+void ClassGetitem::print_head( llvm::raw_ostream& os ) const
+{
+	if ( tag )
+	{
+		gen_def( os );
+	}
+}
+
+void ClassGetitem::print_tail( llvm::raw_ostream& os ) const
+{
+	if ( tag )
 	{
-		return "";
+		os << "\treturn nullptr;\n}\n\n";
 	}
+}
 
-	return def.str() + "\treturn nullptr;\n}\n\n";
+void ClassGetitem::print_def( llvm::raw_ostream& os ) const
+{
+	print_head( os );
+	for ( auto& item : items )
+	{
+		print_item( os, item );
+	}
+	print_tail( os );
 }
 
 }  // namespace binding
@@ -30,7 +30,7 @@ void Compare::gen_sign()
 	}
 }
 
-void Compare::gen_eq()
+void Compare::gen_eq( llvm::raw_ostream& def ) const
 {
 	if ( tag )
 	{
@@ -44,7 +44,7 @@ void Compare::gen_eq()
 	}
 }
 
-void Compare::gen_def()
+void Compare::gen_def( llvm::raw_ostream& def ) const
 {
 	if ( tag )
 	{
@@ -59,14 +59,14 @@ void Compare::gen_def()
 				{
 					if ( method->getOverloadedOperator() == clang::OO_EqualEqual )
 					{
-						gen_eq();
+						gen_eq( def );
 					}
 				}
 			}
 		}
 		else
 		{
-			gen_eq();
+			gen_eq( def );
 		}
 
 		def << "\tPy_INCREF(Py_False);\n\treturn Py_False;\n}\n\n";  // end
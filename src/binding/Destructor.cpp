@@ -6,14 +6,14 @@ namespace pywrap
 {
 namespace binding
 {
-Destructor::Destructor( const Tag& t ) : tag{ t }
+Destructor::Destructor( const Tag& t ) : tag{ &t }
 {
 	// Initialized by the tag
 }
 
 void Destructor::gen_name()
 {
-	name << tag.get_py_name() << "_dealloc";
+	name << tag->get_py_name() << "_dealloc";
 }
 
 void Destructor::gen_sign()
@@ -21,13 +21,13 @@ void Destructor::gen_sign()
 	sign << "void " << name.str() << "( _PyspotWrapper* self )";
 }
 
-void Destructor::gen_def()
+void Destructor::gen_def( llvm::raw_ostream& def ) const
 {
 	def << sign.str() << "\n{\n";
-	if ( !tag.get_templ() )
+	if ( !tag->get_templ() )
 	{
 		def << "\tif ( self->own_data )\n\t{\n"
-		    << "\t\tdelete reinterpret_cast<" << tag.get_qualified_name() << "*>( self->data );\n\t}\n";
+		    << "\t\tdelete reinterpret_cast<" << tag->get_qualified_name() << "*>( self->data );\n\t}\n";
 	}
 	def << "\tPy_TYPE( self )->tp_free( reinterpret_cast<PyObject*>( self ) );\n}\n\n";
 }
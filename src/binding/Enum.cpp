@@ -8,19 +8,5 @@ Enum::Enum( const clang::EnumDecl& e, const Binding& parent ) : Tag{ e, parent }
 {
 	init();
 }
-
-void Enum::gen_reg()
-{
-	Tag::gen_reg();
-
-	for ( auto value : enu.enumerators() )
-	{
-		auto name           = value->getNameAsString();
-		auto qualified_name = get_qualified_name();
-
-		reg << "\tPyDict_SetItemString( " << get_type_object().get_name() << ".tp_dict, \"" << name << "\", pyspot::Wrapper<"
-		    << qualified_name << ">{ " << qualified_name << "::" << name << " }.GetIncref() );\n";
-	}
-}
 }  // namespace binding
 }  // namespace pywrap
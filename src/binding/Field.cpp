@@ -17,11 +17,11 @@ void Getter::gen_sign()
 	sign << "PyObject* " << name.str() << "( _PyspotWrapper* self, void* /*closure*/ )";
 }
 
-void Getter::gen_def()
+void Getter::gen_def( llvm::raw_ostream& def ) const
 {
 	def << sign.str() << "\n{\n"
 	    << "\tauto data = reinterpret_cast<" << field->get_tag().get_qualified_name() << "*>( self->data );\n"
-	    << "\tauto ret = " << to_python( field->get_type(), "data->" + field->get_name() ) << ";\n"
+	    << "\tauto ret = " << to_python( field->get_type(), "data->" + field->get_name(), converters ) << ";\n"
 	    << "\treturn ret;\n"
 	    << "}\n\n";
 }
@@ -36,19 +36,19 @@ void Setter::gen_sign()
 	sign << "int " << name.str() << "( _PyspotWrapper* self, PyObject* value, void* /*closure*/ )";
 }
 
-void Setter::gen_def()
+void Setter::gen_def( llvm::raw_ostream& def ) const
 {
 	def << sign.str() << "\n{\n"
 	    << "\tif ( !value )\n\t{\n"
 	    << "\t\tPyErr_SetString( PyExc_TypeError, \"Cannot delete " << name.str() << "\" );\n"
 	    << "\t\treturn -1;\n\t}\n\n"
 	    << "\tauto data = reinterpret_cast<" << field->get_tag().get_qualified_name() << "*>( self->data );\n"
-	    << "\t" << to_c( field->get_type(), "value", "data->" + field->get_name() ) << ";\n"
+	    << "\t" << to_c( field->get_type(), "value", "data->" + field->get_name(), converters ) << ";\n"
 	    << "\treturn 0;\n}\n\n";
 }
 
 Field::Field( const clang::FieldDecl& f, const Tag& t )
-    : field{ f }, tag{ t }, name{ field.getNameAsString() }, getter{ *this }, setter{ *this }
+    : field{ f }, tag{ &t }, name{ field.getNameAsString() }, getter{ *this }, setter{ *this }
 {
 }
 
@@ -67,7 +67,7 @@ const clang::QualType Field::get_type() const
 {
 	if ( field.isTemplated() )
 	{
-		if ( auto spec = static_cast<const Specialization*>( &tag ) )
+		if ( auto spec = static_cast<const Specialization*>( tag ) )
 		{
 			if ( auto arg = spec->get_arg( field ) )
 			{
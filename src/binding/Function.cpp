@@ -1,7 +1,5 @@
 #include "pywrap/binding/Function.h"
 
-#include <sstream>
-
 #include "pywrap/Util.h"
 
 
@@ -26,23 +24,23 @@ void Function::gen_sign()
 	sign << "( PyObject* self, PyObject* args )";
 }
 
-void Function::gen_def()
+void Function::gen_def( llvm::raw_ostream& def ) const
 {
 	// TODO consider whether it is too complex
 
 	// Open {
 	def << sign.str() << "\n{\n";
 
-	std::stringstream kwlist;
+	Text kwlist;
 	kwlist << "static char* kwlist[] { ";
 
-	std::stringstream fmt;
+	Text fmt;
 	fmt << "static const char* fmt { \"";
-	std::stringstream arg_list;
-	std::stringstream call_arg_list;
+	Text arg_list;
+	Text call_arg_list;
 
 	// Perform the call
-	std::stringstream call;
+	Text call;
 	call << func.getQualifiedNameAsString() << "(";
 
 	// Check if there are parameters
@@ -97,7 +95,7 @@ void Function::gen_def()
 					if ( pPointeeType->isAnyCharacterType() )
 					{
 						def << "PyObject* " << name << ";\n";
-						call_arg_list << pywrap::to_c( qualType, name, "py_arg__" + paramName );
+						call_arg_list << pywrap::to_c( qualType, name, "py_arg__" + paramName, converters );
 					}
 				}
 				else
@@ -112,27 +110,27 @@ void Function::gen_def()
 			arg_list << ", &" << name;
 		}
 
-		def << "\t" << kwlist.rdbuf() << "nullptr };\n";
-		def << "\t" << fmt.rdbuf() << "|\" };\n\n";
+		def << "\t" << kwlist << "nullptr };\n";
+		def << "\t" << fmt << "|\" };\n\n";
 
 		def << "\tif ( !PyArg_ParseTupleAndKeywords( args, kwds, fmt, kwlist," << arg_list.str() <<
 		    // TODO macro for returning Py_None?
 		    " ) )\n\t{\n\t\tPy_INCREF( Py_None );\n\t\treturn Py_None;\n\t}\n\n";
 
-		call << " " << call_arg_list.rdbuf() << " ";
+		call << " " << call_arg_list << " ";
 	}
 	call << ")";
 
 	// If is not returning
 	if ( func.getReturnType()->isVoidType() )
 	{
-		def << "\t" << call.rdbuf()
+		def << "\t" << call
 		    << ";\n"
 		       "\tPy_INCREF( Py_None );\n\treturn Py_None;\n}\n\n";
 	}
 	else
 	{
-		def << "\tauto ret = " << pywrap::to_python( func.getReturnType(), call.str() ) << ";\n";
+		def << "\tauto ret = " << pywrap::to_python( func.getReturnType(), call.str(), converters ) << ";\n";
 		def << "\treturn ret;\n";
 	}
 
@@ -22,7 +22,7 @@ void Init::gen_sign()
 	sign << "int " << name.str() << "( _PyspotWrapper* self, PyObject* args, PyObject* kwds )";
 }
 
-void Init::gen_def()
+void Init::gen_def( llvm::raw_ostream& def ) const
 {
 	// Template is trivial
 	if ( tag->get_templ() )
@@ -62,14 +62,14 @@ void Init::gen_def()
 			{
 				if ( !constructor->isCopyOrMoveConstructor() )
 				{
-					add_def( *constructor );
+					add_def( def, *constructor );
 				}
 			}
 		}
 	}
 }
 
-void Init::add_def( const clang::CXXConstructorDecl& constructor )
+void Init::add_def( llvm::raw_ostream& def, const clang::CXXConstructorDecl& constructor ) const
 {
 	// Calculates args and kwds size
 	int args_count = 0;  // signed for count will become negative
@@ -87,15 +87,15 @@ void Init::add_def( const clang::CXXConstructorDecl& constructor )
 	auto kwlist_name = std::string{ "kvlist" };
 	auto fmt_name    = std::string{ "fmt" };
 
-	std::stringstream kwlist_def;
+	Text kwlist_def;
 	kwlist_def << "char* " << kwlist_name << "[] { ";
 
-	std::stringstream fmt_def;
+	Text fmt_def;
 	fmt_def << "const char* " << fmt_name << " { \"";
 
-	std::stringstream args_pointers;
-	std::stringstream call_args;
-	std::stringstream pre_call_args;
+	Text args_pointers;
+	Text call_args;
+	Text pre_call_args;
 
 	for ( auto param : constructor.parameters() )
 	{
@@ -125,7 +125,7 @@ void Init::add_def( const clang::CXXConstructorDecl& constructor )
 		else
 		{
 			def << "PyObject* ";
-			pre_call_args << "auto " << pywrap::to_c( param->getType(), param_name, "c_" + param_name ) << ";\n";
+			pre_call_args << "auto " << pywrap::to_c( param->getType(), param_name, "c_" + param_name, converters ) << ";\n";
 			call_args << "c_" << param_name << ", ";
 		}
 		def << param_name << " {};\n";
@@ -149,8 +149,8 @@ void Init::add_def( const clang::CXXConstructorDecl& constructor )
 		call_args_str = call_args_str.substr( 0, call_args_str.size() - 2 );
 	}
 
-	def << "\t\t" << kwlist_def.rdbuf() << "nullptr };\n";
-	def << "\t\t" << fmt_def.rdbuf() << "\" };\n\n";
+	def << "\t\t" << kwlist_def << "nullptr };\n";
+	def << "\t\t" << fmt_def << "\" };\n\n";
 
 	// Parse tuple and keywords
 	def << "\t\tif ( PyArg_ParseTupleAndKeywords( args, kwds, " << fmt_name << ", " << kwlist_name << args_pointers.str()
@@ -169,14 +169,13 @@ void Init::add_def( const clang::CXXConstructorDecl& constructor )
 	def << "\t}\n";
 }
 
-std::string Init::get_def() const
+void Init::print_def( llvm::raw_ostream& os ) const
 {
-	auto ret = def.str();
-	if ( tag->get_templ() )
+	gen_def( os );
+	if ( !tag->get_templ() )
 	{
-		return ret;
+		os << "\treturn -1;\n}\n\n";
 	}
-	return ret + "\treturn -1;\n}\n\n";
 }
 }  // namespace binding
 }  // namespace pywrap
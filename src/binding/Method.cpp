@@ -25,7 +25,7 @@ void Method::gen_sign()
 	sign << "( PyObject* self, PyObject* args, PyObject* kwds )";
 }
 
-void Method::gen_def()
+void Method::gen_def( llvm::raw_ostream& def ) const
 {
 	// TODO implementation
 	def << sign.str() << "\n{}\n\n";
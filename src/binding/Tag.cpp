@@ -34,7 +34,7 @@ void Tag::Methods::gen_sign()
 }
 
 
-void Tag::Methods::gen_def()
+void Tag::Methods::gen_def( llvm::raw_ostream& def ) const
 {
 	if ( tag )
 	{
@@ -42,7 +42,6 @@ void Tag::Methods::gen_def()
 		if ( tag->get_templ() )
 		{
 			auto templ = static_cast<const Template*>( tag );
-			size++;
 			def << "\t{ \"__class_getitem__\", " << templ->get_class_getitem().get_py_name()
 			    << ", METH_O|METH_CLASS, NULL },\n";
 		}
@@ -50,47 +49,23 @@ void Tag::Methods::gen_def()
 }
 
 
-std::string Tag::Methods::get_decl() const
+void Tag::Methods::print_decl( llvm::raw_ostream& os ) const
 {
-	if ( !tag )
-	{
-		return "";
-	}
-
-	return "extern " + sign.str() + "[" + std::to_string( size ) + "];\n";
-}
-
-
-std::string Tag::Methods::get_def() const
-{
-	if ( !tag )
-	{
-		return "";
-	}
-
-	return def.str() + "\t{ NULL, NULL, 0, NULL } // sentinel\n};\n\n";
-}
-
-
-const char* gen_meth( const Method& m )
-{
-	if ( m->param_size() == 0 )
-	{
-		return "METH_NOARGS";
-	}
-	else
+	if ( tag )
 	{
-		return "METH_VARARGS | METH_KEYWORDS";
+		// A template also has its __class_getitem__
+		size_t size = tag->get_templ() ? 2 : 1;
+		os << "extern " << sign.str() << "[" << size << "];\n";
 	}
 }
 
 
-void Tag::Methods::add( const Method& method )
+void Tag::Methods::print_def( llvm::raw_ostream& os ) const
 {
 	if ( tag )
 	{
-		def << "\t{ \"" << method.get_name() << "\", " << method.get_py_name() << ", " << gen_meth( method ) << ", \""
-		    << method.get_name() << "\" },\n";
+		gen_def( os );
+		os << "\t{ NULL, NULL, 0, NULL } // sentinel\n};\n\n";
 	}
 }
 
@@ -122,7 +97,7 @@ void Tag::Members::gen_sign()
 }
 
 
-void Tag::Members::gen_def()
+void Tag::Members::gen_def( llvm::raw_ostream& def ) const
 {
 	if ( tag )
 	{
@@ -133,14 +108,13 @@ void Tag::Members::gen_def()
 }
 
 
-std::string Tag::Members::get_decl() const
+void Tag::Members::print_decl( llvm::raw_ostream& os ) const
 {
-	if ( !tag )
+	if ( tag )
 	{
-		return "";
+		// Only the sentinel
+		os << "extern " << sign.str() << "[1];\n\n";
 	}
-
-	return "extern " + sign.str() + "[" + std::to_string( size ) + "];\n\n";
 }
 
 
@@ -171,7 +145,19 @@ void Tag::Accessors::gen_sign()
 }
 
 
-void Tag::Accessors::gen_def()
+size_t Tag::Accessors::get_size() const
+{
+	if ( clang::dyn_cast<clang::CXXRecordDecl>( tag->get_handle() ) )
+	{
+		auto record = static_cast<const CXXRecord*>( tag );
+		return record->get_fields().size() + 1;
+	}
+
+	return 1;
+}
+
+
+void Tag::Accessors::gen_def( llvm::raw_ostream& def ) const
 {
 	if ( tag )
 	{
@@ -181,8 +167,6 @@ void Tag::Accessors::gen_def()
 		if ( clang::dyn_cast<clang::CXXRecordDecl>( tag->get_handle() ) )
 		{
 			auto record = static_cast<const CXXRecord*>( tag );
-			size += record->get_fields().size();
-
 			for ( auto& field : record->get_fields() )
 			{
 				def << "\t{ \"" << field.get_name() << "\", reinterpret_cast<getter>( " << field.get_getter().get_name()
@@ -196,19 +180,17 @@ void Tag::Accessors::gen_def()
 }
 
 
-std::string Tag::Accessors::get_decl() const
+void Tag::Accessors::print_decl( llvm::raw_ostream& os ) const
 {
 	if ( tag )
 	{
-		return "extern " + sign.str() + "[" + std::to_string( size ) + "];\n\n";
+		os << "extern " << sign.str() << "[" << get_size() << "];\n\n";
 	}
-	return "";
 }
 
 
 Tag::Tag( Tag&& o )
     : Binding{ std::move( o ) }
-    , reg{ std::move( o.reg ) }
     , tag{ o.tag }
     , templ{ o.templ }
     , destructor{ std::move( o.destructor ) }
@@ -221,7 +203,16 @@ Tag::Tag( Tag&& o )
     , type_object{ std::move( o.type_object ) }
     , wrapper{ std::move( o.wrapper ) }
 {
-	initializer.tag = this;
+	// Parts refer to their tag while they are printed
+	destructor.tag    = this;
+	initializer.tag   = this;
+	compare.tag       = compare.tag ? this : nullptr;
+	class_getitem.tag = class_getitem.tag ? this : nullptr;
+	methods.tag       = methods.tag ? this : nullptr;
+	members.tag       = members.tag ? this : nullptr;
+	accessors.tag     = accessors.tag ? this : nullptr;
+	type_object.tag   = this;
+	wrapper.tag       = wrapper.tag ? this : nullptr;
 }
 
 
@@ -265,35 +256,48 @@ void Tag::init()
 	accessors.init();
 	type_object.init();
 	wrapper.init();
-	gen_reg();
 }
 
 
-void Tag::gen_reg()
+void Tag::print_decl( llvm::raw_ostream& os ) const
 {
-	auto type_object_name = type_object.get_name();
-
-	reg << "\tif ( PyType_Ready( &" << type_object_name << " ) < 0 )\n"
-	    << "\t{\n\t\treturn nullptr;\n\t}\n"
-	    << "\tPy_INCREF( &" << type_object_name << " );\n"
-	    << "\tPyModule_AddObject( " << parent->get_py_name() << ", \"" << get_name() << "\", "
-	    << "reinterpret_cast<PyObject*>( &" << type_object_name << " ) );\n\n";
+	// These declarations will go within extern "C"
+	// Wrapper decl should not go there
+	destructor.print_decl( os );
+	initializer.print_decl( os );
+	compare.print_decl( os );
+	class_getitem.print_decl( os );
+	methods.print_decl( os );
+	members.print_decl( os );
+	accessors.print_decl( os );
+	type_object.print_decl( os );
 }
 
 
-std::string Tag::get_decl() const
+void Tag::print_def( llvm::raw_ostream& os ) const
 {
-	// These declarations will go within extern "C"
-	// Wrapper decl should not go there
-	return destructor.get_decl() + initializer.get_decl() + compare.get_decl() + class_getitem.get_decl() +
-	       methods.get_decl() + members.get_decl() + accessors.get_decl() + type_object.get_decl();
+	print_open_def( os );
+	for ( auto& item : class_getitem.get_items() )
+	{
+		ClassGetitem::print_item( os, item );
+	}
+	class_getitem.print_tail( os );
 }
 
 
-std::string Tag::get_def() const
+void Tag::print_open_def( llvm::raw_ostream& os ) const
 {
-	return destructor.get_def() + initializer.get_def() + compare.get_def() + class_getitem.get_def() + methods.get_def() +
-	       members.get_def() + accessors.get_def() + type_object.get_def() + wrapper.get_def();
+	destructor.print_def( os );
+	initializer.print_def( os );
+	compare.print_def( os );
+	methods.print_def( os );
+	members.print_def( os );
+	accessors.print_def( os );
+	type_object.print_def( os );
+	wrapper.print_def( os );
+
+	// Last, so the cases can follow
+	class_getitem.print_head( os );
 }
 
 
@@ -6,7 +6,7 @@ namespace pywrap
 {
 namespace binding
 {
-TypeObject::TypeObject( const Tag& t ) : tag{ t }
+TypeObject::TypeObject( const Tag& t ) : tag{ &t }
 {
 	// Tag is not initialized yet
 	// TypeObject should be initialized by its Tag
@@ -14,7 +14,7 @@ TypeObject::TypeObject( const Tag& t ) : tag{ t }
 
 void TypeObject::gen_name()
 {
-	name << tag.get_py_name() << "_type_object";
+	name << tag->get_py_name() << "_type_object";
 }
 
 void TypeObject::gen_py_name()
@@ -27,20 +27,20 @@ void TypeObject::gen_sign()
 	sign << "PyTypeObject " << get_py_name();
 }
 
-void TypeObject::gen_decl()
+void TypeObject::gen_decl( llvm::raw_ostream& decl ) const
 {
 	decl << "extern " << get_sign() << ";\n\n";
 }
 
-void TypeObject::gen_def()
+void TypeObject::gen_def( llvm::raw_ostream& def ) const
 {
 	def << get_sign()
 	    << " = {\n"
 	       "\tPyVarObject_HEAD_INIT( NULL, 0 )\n\n"
-	    << "\t\"" << tag.get_qualified_name() << "\", // name\n"
+	    << "\t\"" << tag->get_qualified_name() << "\", // name\n"
 	    << "\tsizeof( _PyspotWrapper ), // basicsize\n"
 	       "\t0, // itemsize\n\n"
-	    << "\treinterpret_cast<destructor>( " << tag.get_destructor().get_name() << " ), // dealloc\n"
+	    << "\treinterpret_cast<destructor>( " << tag->get_destructor().get_name() << " ), // dealloc\n"
 	    << "\t0, // print\n"
 	       "\t0, // getattr\n"
 	       "\t0, // setattr\n"
@@ -56,22 +56,22 @@ void TypeObject::gen_def()
 	       "\t0, // setattro\n\n"
 	       "\t0, // as_buffer\n\n"
 	       "\tPy_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, // flags\n\n"
-	    << "\t\"" << tag.get_qualified_name() << "\", // doc\n\n"
+	    << "\t\"" << tag->get_qualified_name() << "\", // doc\n\n"
 	    << "\t0, // traverse\n\n"
 	       "\t0, // clear\n\n"
-	    << "\treinterpret_cast<richcmpfunc>( " << tag.get_compare().get_name() << " ), // richcompare\n\n"
+	    << "\treinterpret_cast<richcmpfunc>( " << tag->get_compare().get_name() << " ), // richcompare\n\n"
 	    << "\t0, // weaklistoffset\n\n"
 	       "\t0, // iter\n"
 	       "\t0, // iternext\n\n"
-	    << "\t" << tag.get_methods().get_py_name() << ", // methods\n"
-	    << "\t" << tag.get_members().get_py_name() << ", // members\n"
-	    << "\t" << tag.get_accessors().get_py_name() << ", // getset\n"
+	    << "\t" << tag->get_methods().get_py_name() << ", // methods\n"
+	    << "\t" << tag->get_members().get_py_name() << ", // members\n"
+	    << "\t" << tag->get_accessors().get_py_name() << ", // getset\n"
 	    << "\t0, // base\n"
 	       "\t0, // dict\n"
 	       "\t0, // descr_get\n"
 	       "\t0, // descr_set\n"
 	       "\t0, // dictoffset\n"
-	    << "\treinterpret_cast<initproc>( " << tag.get_init().get_name() << " ), // init\n"
+	    << "\treinterpret_cast<initproc>( " << tag->get_init().get_name() << " ), // init\n"
 	    << "\t0, // alloc\n"
 	       "\tPyspotWrapper_new, // new\n};\n\n";
 }
@@ -25,23 +25,13 @@ void Wrapper::gen_sign()
 }
 
 
-void Wrapper::gen_decl()
+void Wrapper::gen_decl( llvm::raw_ostream& /*decl*/ ) const
 {
-	if ( !tag )
-	{
-		return;
-	}
-
-	// Pointer constructor
-	decl << sign.str() << tag->get_qualified_name() << "* v );\n\n";
-	// Copy constructor
-	decl << sign.str() << "const " << tag->get_qualified_name() << "& v );\n\n";
-	// Move constructor
-	decl << sign.str() << tag->get_qualified_name() << "&& v );\n\n";
+	// The printer declares the constructors from the qualified name of the tag
 }
 
 
-void Wrapper::gen_pointer_constructor_def()
+void Wrapper::gen_pointer_constructor_def( llvm::raw_ostream& def ) const
 {
 	if ( !tag )
 	{
@@ -62,7 +52,7 @@ void Wrapper::gen_pointer_constructor_def()
 }
 
 
-void Wrapper::gen_copy_constructor_def()
+void Wrapper::gen_copy_constructor_def( llvm::raw_ostream& def ) const
 {
 	if ( !tag )
 	{
@@ -84,7 +74,7 @@ void Wrapper::gen_copy_constructor_def()
 }
 
 
-void Wrapper::gen_move_constructor_def()
+void Wrapper::gen_move_constructor_def( llvm::raw_ostream& def ) const
 {
 	if ( !tag )
 	{
@@ -105,26 +95,26 @@ void Wrapper::gen_move_constructor_def()
 }
 
 
-void Wrapper::gen_def()
+void Wrapper::gen_def( llvm::raw_ostream& def ) const
 {
-	gen_pointer_constructor_def();
+	gen_pointer_constructor_def( def );
 
 	if ( tag && clang::dyn_cast<clang::CXXRecordDecl>( tag->get_handle() ) )
 	{
 		auto record = static_cast<const CXXRecord*>( tag );
 		if ( record->get_record().hasSimpleCopyConstructor() )
 		{
-			gen_copy_constructor_def();
+			gen_copy_constructor_def( def );
 		}
 		if ( record->get_record().hasSimpleMoveConstructor() )
 		{
-			gen_move_constructor_def();
+			gen_move_constructor_def( def );
 		}
 	}
 	else
 	{
-		gen_copy_constructor_def();
-		gen_move_constructor_def();
+		gen_copy_constructor_def( def );
+		gen_move_constructor_def( def );
 	}
 }
 